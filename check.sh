@@ -0,0 +1,42 @@
+#!/bin/bash
+# Checks that the optimizations of `seq` do not change the model: the lazy
+# decay of the first layer against decaying every weight, and, with a fixed
+# seed, the scores of 1 and 3 threads and of the generic and specialized
+# kernels.
+#
+# usage: ./check.sh [<epochs> <seed>]
+# Exits 1 if a check fails and 2 if a run fails.
+
+EPOCHS=${1:-2}
+SEED=${2:-1}
+
+make -s seq bin/check || exit 2
+
+cd bin
+./check || exit 1
+
+# Prints the accuracy and F1 of a run of `seq`.
+scores() {
+  ./seq -e $EPOCHS --seed $SEED "$@" | awk '/^(accuracy|f1):/ { print $2 }'
+}
+
+# Runs `seq` with the options on either side of `--` and compares the scores.
+same() {
+  local a=() b=() A B
+  while [ "$1" != "--" ]; do a+=("$1"); shift; done
+  shift
+  b=("$@")
+  A=$(scores "${a[@]}") || exit 2
+  B=$(scores "${b[@]}") || exit 2
+  if [ -z "$A" ] || [ "$A" != "$B" ]; then
+    echo "check: ${a[*]} and ${b[*]} differ:" $A / $B >&2
+    exit 1
+  fi
+  echo "${a[*]} = ${b[*]}:" $A
+}
+
+same -n 16 -t 1 -- -n 16 -t 3
+# `-t 1` skips the tuning cache, which could pick the generic kernel.
+same -n 8 -t 1 -- -n 8 -k
+same -l 0 -t 1 -- -l 0 -k
+echo "check: ok"
@@ -14,6 +14,7 @@ import java.util.HashMap;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Map;
+import java.util.Random;
 import java.util.Scanner;
 import java.util.Set;
 
@@ -96,6 +97,18 @@ public class Data {
     }
   }
 
+  /**
+   * shuffle
+   *   Shuffles a data set with the given random number generator.
+   */
+  public static <T1, T2> void shuffle(List<T1> l1, List<T2> l2, Random rng) {
+    for(int i = 0; i < l1.size(); i++) {
+      int j = rng.nextInt(l1.size());
+      swap(i, j, l1);
+      swap(i, j, l2);
+    }
+  }
+
   /**
    * swap
    *   Swaps two values in a list.
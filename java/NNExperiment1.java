@@ -3,22 +3,41 @@
 // CS 5350 - Machine Learning
 // Fall 2016
 // Date created: December 5, 2016
-// Last updated: December 5, 2016
+// Last updated: October 18, 2026
+//
+// Usage: NNExperiment1 [<layers> <layer nodes> <epochs> <gamma0> [<seed>]]
+//   The defaults are 1 layer of 8 nodes, 100 epochs, a gamma0 of 0.01 and a
+//   seed from the time. `parity.sh` runs this with the settings of `seq`.
 
 package ml;
 
 import java.util.Arrays;
 import java.util.HashSet;
 import java.util.List;
+import java.util.Random;
 import java.util.Set;
 
 public class NNExperiment1 extends Experiment {
 
   public static void main(String[] args) {
-    (new NNExperiment1()).run();
+    NNExperiment1 experiment = new NNExperiment1();
+    if (args.length >= 4) {
+      experiment.layers = Integer.parseInt(args[0]);
+      experiment.layerNodes = Integer.parseInt(args[1]);
+      experiment.epochs = Integer.parseInt(args[2]);
+      experiment.g0 = Double.parseDouble(args[3]);
+    }
+    if (args.length >= 5)
+      experiment.rng = new Random(Long.parseLong(args[4]));
+    experiment.run();
   }
 
   private double[][][] W;
+  private int layers = 1;
+  private int layerNodes = 8;
+  private int epochs = 100;
+  private double g0 = 0.01;
+  private Random rng = new Random();
   // private Set<Integer> remove = null;
 
   public double getPrediction(double[] x_i) {
@@ -63,9 +82,9 @@ public class NNExperiment1 extends Experiment {
     //   X.set(i, x_ip);
     // }
 
-    final int LAYERS = 1;
+    final int LAYERS = layers;
     // final int LAYER_NODES = X.size();
-    final int LAYER_NODES = 8;
+    final int LAYER_NODES = layerNodes;
     // final int LAYER_NODES = X.get(0).length / 2;
     // final int LAYER_NODES = (int)Math.log(X.get(0).length);
     // final int LAYER_NODES = (int)Math.log(X.size());
@@ -73,7 +92,9 @@ public class NNExperiment1 extends Experiment {
 
     println("Layers: " + LAYERS);
     println("Layer nodes: " + LAYER_NODES);
-    W = train(X, Y, LAYERS, LAYER_NODES, 100, 0.01);
+    long start = System.nanoTime();
+    W = train(X, Y, LAYERS, LAYER_NODES, epochs, g0);
+    println("train time: " + (System.nanoTime() - start) / 1e9 + " s");
     println("dataset\tacc\tpre\trec\tF1");
     StringBuilder sb = new StringBuilder();
     appendStringBuilder(sb, "train\t");
@@ -117,7 +138,7 @@ public class NNExperiment1 extends Experiment {
       }
     }
     w[layers] = new double[1][]; // Final layer has 1 node (the output node)
-    w[layers][0] = new double[layerNodes + 1];
+    w[layers][0] = new double[layers > 0 ? layerNodes + 1 : x.get(0).length];
     reset(w);
 
     System.out.println("# w");
@@ -134,8 +155,13 @@ public class NNExperiment1 extends Experiment {
     for (int l = 1; l < w.length; l++)
       z[l] = new double[w[l - 1].length + 1];
 
+    // Deltas of the nodes of each layer.
+    double[][] d = new double[w.length][];
+    for (int l = 0; l < w.length; l++)
+      d[l] = new double[w[l].length];
+
     for (int e = 0; e < epochs; e++) {
-      Data.shuffle(x, y);
+      Data.shuffle(x, y, rng);
       for (int i = 0; i < x.size(); i++) {
 
         // Compute yp and remember hidden layer features.
@@ -152,22 +178,22 @@ public class NNExperiment1 extends Experiment {
         // Save derivitive of square loss.
         double dLy = (yp - y.get(i));
 
-        // Back propagation.
-
-        int l = w.length - 1;
-        for (int j = 0; j < w[l][0].length; j++) {
-          w_swap[l][0][j] = w[l][0][j] - g0 * dLy * z[l][j];
-          z[l][j] *= (1 - z[l][j]);
-        }
-
-        for (l = l - 1; l >= 0; l--) {
+        // Back propagation. The delta of node n of layer l is the sum of the
+        // deltas of the next layer weighted by their weights from node n,
+        // times the derivative of the sigmoid at node n.
+        d[w.length - 1][0] = dLy;
+        for (int l = w.length - 2; l >= 0; l--) {
           for (int n = 0; n < w[l].length; n++) {
-            for (int j = 0; j < w[l][n].length; j++)
-              w_swap[l][n][j] = w[l][n][j] - g0 * dLy * propagate(w, z, l, n, j);
-            for (int j = 0; j < w[l][n].length; j++)
-              z[l][j] *= (1 - z[l][j]);
+            double s = 0;
+            for (int k = 0; k < w[l + 1].length; k++)
+              s += w[l + 1][k][n + 1] * d[l + 1][k];
+            d[l][n] = s * z[l + 1][n + 1] * (1 - z[l + 1][n + 1]);
           }
         }
+        for (int l = 0; l < w.length; l++)
+          for (int n = 0; n < w[l].length; n++)
+            for (int j = 0; j < w[l][n].length; j++)
+              w_swap[l][n][j] = w[l][n][j] - g0 * d[l][n] * z[l][j];
         double[][][] temp = w;
         w = w_swap;
         w_swap = temp;
@@ -182,23 +208,11 @@ public class NNExperiment1 extends Experiment {
     return w;
   }
 
-  private static double propagate(double[][][] w, double[][] z, int l, int n, int j) {
-    double result = 0;
-
-    if (l + 2 < w.length) {
-      for (int n1 = 0; n1 < w[l + 1].length; n1++)
-        result += z[l][j] * w[l + 1][n1][n + 1] * propagate(w, z, l + 1, n1, n + 1);
-    } else
-      result = z[l][j] * w[l + 1][0][n + 1] * z[l + 1][n + 1];
-
-    return result;
-  }
-
   private void reset(double[][][] w) {
     for (double[][] l : w)
       for (double[] n : l)
         for (int j = 0; j < n.length; j++)
-          n[j] = Math.random() * 2 - 1;
+          n[j] = rng.nextDouble() * 2 - 1;
     // n[j] = 1;
   }
 
@@ -0,0 +1,334 @@
+/*** Generated by genkern; do not edit. ***/
+
+#include <stddef.h>
+
+#include "kern.h"
+
+static void traink0(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = featureCount;
+    double dLy;
+    (void)z;
+    (void)d;
+    dLy = dot(w, x_i, f) - y_i;
+    updateLayer(w, x_i, f, 1, &dLy, gamma0, lazy->decay);
+}
+
+static double predictk0(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = featureCount;
+    (void)zA;
+    (void)zB;
+    return dot(w, x_i, f);
+}
+
+static void traink0_8(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 8, 8, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 8, z);
+    dLy = dot(w + 8 * f + 0, z + 0, 9) - y_i;
+    backLayer(w + 8 * f + 0, 9, 1, &dLy, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 8, 8, d, gamma0, lazy->decay);
+    updateLayer(w + 8 * f + 0, z + 0, 9, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk0_8(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 8, zA);
+    return dot(w + 8 * f + 0, zA, 9);
+}
+
+static void traink0_16(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 16, 16, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 16, z);
+    dLy = dot(w + 16 * f + 0, z + 0, 17) - y_i;
+    backLayer(w + 16 * f + 0, 17, 1, &dLy, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 16, 16, d, gamma0, lazy->decay);
+    updateLayer(w + 16 * f + 0, z + 0, 17, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk0_16(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 16, zA);
+    return dot(w + 16 * f + 0, zA, 17);
+}
+
+static void traink0_180(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 180, 180, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 180, z);
+    dLy = dot(w + 180 * f + 0, z + 0, 181) - y_i;
+    backLayer(w + 180 * f + 0, 181, 1, &dLy, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 180, 180, d, gamma0, lazy->decay);
+    updateLayer(w + 180 * f + 0, z + 0, 181, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk0_180(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 180, zA);
+    return dot(w + 180 * f + 0, zA, 181);
+}
+
+static void traink0_256_64_16(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 256, 256, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 256, z);
+    forwardLayer(z + 0, 257, w + 256 * f + 0, 64, z + 257);
+    forwardLayer(z + 257, 65, w + 256 * f + 16448, 16, z + 322);
+    dLy = dot(w + 256 * f + 17488, z + 322, 17) - y_i;
+    backLayer(w + 256 * f + 17488, 17, 1, &dLy, z + 322, d + 320);
+    backLayer(w + 256 * f + 16448, 65, 16, d + 320, z + 257, d + 256);
+    backLayer(w + 256 * f + 0, 257, 64, d + 256, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 256, 256, d, gamma0, lazy->decay);
+    updateLayer(w + 256 * f + 0, z + 0, 257, 64, d + 256, gamma0, lazy->decay);
+    updateLayer(w + 256 * f + 16448, z + 257, 65, 16, d + 320, gamma0, lazy->decay);
+    updateLayer(w + 256 * f + 17488, z + 322, 17, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk0_256_64_16(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 256, zA);
+    forwardLayer(zA, 257, w + 256 * f + 0, 64, zB);
+    forwardLayer(zB, 65, w + 256 * f + 16448, 16, zA);
+    return dot(w + 256 * f + 17488, zA, 17);
+}
+
+static void traink131(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = 131;
+    (void)featureCount;
+    double dLy;
+    (void)z;
+    (void)d;
+    dLy = dot(w, x_i, f) - y_i;
+    updateLayer(w, x_i, f, 1, &dLy, gamma0, lazy->decay);
+}
+
+static double predictk131(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = 131;
+    (void)featureCount;
+    (void)zA;
+    (void)zB;
+    return dot(w, x_i, f);
+}
+
+static void traink131_8(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = 131;
+    (void)featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 8, 8, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 8, z);
+    dLy = dot(w + 8 * f + 0, z + 0, 9) - y_i;
+    backLayer(w + 8 * f + 0, 9, 1, &dLy, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 8, 8, d, gamma0, lazy->decay);
+    updateLayer(w + 8 * f + 0, z + 0, 9, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk131_8(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = 131;
+    (void)featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 8, zA);
+    return dot(w + 8 * f + 0, zA, 9);
+}
+
+static void traink131_180(
+    const int featureCount,
+    const double * const x_i,
+    const double y_i,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+) {
+    const int f = 131;
+    (void)featureCount;
+    int nz[f], nzCount;
+    double dLy;
+    nzCount = nonzeros(x_i, f, nz);
+    catchUpColumns(w, 180, 180, nz, nzCount, lazy);
+    forwardInput(x_i, nz, nzCount, w, 180, z);
+    dLy = dot(w + 180 * f + 0, z + 0, 181) - y_i;
+    backLayer(w + 180 * f + 0, 181, 1, &dLy, z + 0, d + 0);
+    updateColumns(w, x_i, nz, nzCount, 180, 180, d, gamma0, lazy->decay);
+    updateLayer(w + 180 * f + 0, z + 0, 181, 1, &dLy, gamma0, lazy->decay);
+    advanceLazy(nz, nzCount, lazy);
+}
+
+static double predictk131_180(
+    const int featureCount,
+    const double * const x_i,
+    const double * const w,
+    double * const zA,
+    double * const zB
+) {
+    const int f = 131;
+    (void)featureCount;
+    int nz[f], nzCount = nonzeros(x_i, f, nz);
+    forwardInput(x_i, nz, nzCount, w, 180, zA);
+    return dot(w + 180 * f + 0, zA, 181);
+}
+
+static const kernel kernels[] = {
+    { "0", 0, 0, { }, traink0, predictk0 },
+    { "8", 0, 1, { 8 }, traink0_8, predictk0_8 },
+    { "16", 0, 1, { 16 }, traink0_16, predictk0_16 },
+    { "180", 0, 1, { 180 }, traink0_180, predictk0_180 },
+    { "256,64,16", 0, 3, { 256, 64, 16 }, traink0_256_64_16, predictk0_256_64_16 },
+    { "131:0", 131, 0, { }, traink131, predictk131 },
+    { "131:8", 131, 1, { 8 }, traink131_8, predictk131_8 },
+    { "131:180", 131, 1, { 180 }, traink131_180, predictk131_180 },
+    { NULL, 0, 0, { 0 }, NULL, NULL }
+};
+
+const kernel *findKernel(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+) {
+    int i, j;
+    const kernel *result = NULL;
+    for(i = 0; kernels[i].name != NULL; i++) {
+        if(kernels[i].layerCount != layerCount)
+            continue;
+        if(kernels[i].featureCount != 0 &&
+            kernels[i].featureCount != featureCount)
+            continue;
+        for(j = 0; j < layerCount; j++)
+            if(kernels[i].layerNodeCounts[j] != layerNodeCounts[j])
+                break;
+        if(j < layerCount)
+            continue;
+        /*** Prefer a constant number of input features. ***/
+        if(result == NULL || kernels[i].featureCount != 0)
+            result = &kernels[i];
+    }
+    return result;
+}
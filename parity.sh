@@ -0,0 +1,55 @@
+#!/bin/bash
+# Trains `seq` and the Java reference on data/data.train with the same
+# topology, epochs, gamma0 and seed, checks that their test accuracy and F1
+# agree within a tolerance, and reports the ratio of their training times.
+#
+# usage: ./parity.sh [<layers> <layer nodes> <epochs> <gamma0> <seed> <tol>]
+# Exits 1 if the scores disagree and 2 if a run fails.
+
+LAYERS=${1:-1}
+NODES=${2:-8}
+EPOCHS=${3:-100}
+GAMMA=${4:-0.01}
+SEED=${5:-1}
+TOL=${6:-0.03}
+
+if ! command -v javac > /dev/null || ! command -v java > /dev/null; then
+  echo "parity: javac and java are required" >&2
+  exit 2
+fi
+find java/ -name '*.java' | xargs javac -d bin || exit 2
+make -s seq || exit 2
+
+cd bin
+C_OUT=$(./seq -l $LAYERS -n $NODES -e $EPOCHS -g $GAMMA --seed $SEED) || exit 2
+J_OUT=$(java -Xmx4096M -cp . ml/NNExperiment1 $LAYERS $NODES $EPOCHS $GAMMA \
+  $SEED) || exit 2
+EXAMPLES=$(grep -c . data/data.train)
+
+C_ACC=$(echo "$C_OUT" | awk '/^accuracy:/ { print $2 }')
+C_F1=$(echo "$C_OUT" | awk '/^f1:/ { print $2 }')
+C_TIME=$(echo "$C_OUT" | awk '/^train time:/ { print $3 }')
+J_ACC=$(echo "$J_OUT" | awk -F '\t' '$1 == "test" { print $2 }')
+J_F1=$(echo "$J_OUT" | awk -F '\t' '$1 == "test" { print $5 }')
+J_TIME=$(echo "$J_OUT" | awk '/^train time:/ { print $3 }')
+
+if [ -z "$C_ACC" ] || [ -z "$C_F1" ] || [ -z "$C_TIME" ] || [ -z "$J_ACC" ] \
+  || [ -z "$J_F1" ] || [ -z "$J_TIME" ]; then
+  echo "parity: could not read the results" >&2
+  exit 2
+fi
+
+awk -v ca=$C_ACC -v cf=$C_F1 -v ct=$C_TIME -v ja=$J_ACC -v jf=$J_F1 \
+  -v jt=$J_TIME -v n=$EXAMPLES -v e=$EPOCHS -v tol=$TOL '
+  function abs(v) { return v < 0 ? -v : v }
+  BEGIN {
+    printf("\tacc\tF1\ttime (s)\texamples/s\n")
+    printf("c\t%.3f\t%.3f\t%f\t%.0f\n", ca, cf, ct, n * e / ct)
+    printf("java\t%.3f\t%.3f\t%f\t%.0f\n", ja, jf, jt, n * e / jt)
+    printf("speedup: %.2f\n", jt / ct)
+    if(abs(ca - ja) > tol || abs(cf - jf) > tol) {
+      printf("parity: scores differ by more than %s\n", tol)
+      exit 1
+    }
+    printf("parity: ok\n")
+  }'
@@ -0,0 +1,88 @@
+/*******************************************************************************
+File: check.c
+Created by: agent
+Date created: October 18, 2026
+
+Checks that the lazy decay of the first layer gives the same weights as
+decaying every weight at every step.
+
+Compile with:
+```
+$ gcc -Wall -o check check.c -lm
+```
+
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kern.h"
+
+/*** Number of features, nodes and steps of the check ***/
+#define CHECK_FEATURES 64
+#define CHECK_NODES 8
+#define CHECK_STEPS 1000
+
+/*** Largest difference allowed between the two sets of weights ***/
+#define CHECK_TOLERANCE 1e-12
+
+/** Main **********************************************************************/
+
+int main(void) {
+    int i, j, k, nzCount, nz[CHECK_FEATURES];
+    unsigned int seed = 1;
+    long stamp[CHECK_FEATURES] = { 0 };
+    double x[CHECK_FEATURES], d[CHECK_NODES], diff, maxDiff = 0;
+    double lazyW[CHECK_FEATURES * CHECK_NODES];
+    double eagerW[CHECK_FEATURES * CHECK_NODES];
+    const double gamma0 = 0.01, lambda = 0.5;
+    lazyDecay lazy;
+
+    lazy.decay = 1 - gamma0 * lambda;
+    lazy.step = 0;
+    lazy.stamp = stamp;
+    for(k = 0; k < CHECK_FEATURES * CHECK_NODES; k++)
+        lazyW[k] = eagerW[k] = (double)rand_r(&seed) / RAND_MAX * 2 - 1;
+
+    for(i = 0; i < CHECK_STEPS; i++) {
+        /*** An example with about a quarter of its features non-zero. ***/
+        for(k = 0; k < CHECK_FEATURES; k++)
+            x[k] = (rand_r(&seed) % 4 == 0
+                ? (double)rand_r(&seed) / RAND_MAX
+                : 0);
+        for(j = 0; j < CHECK_NODES; j++)
+            d[j] = (double)rand_r(&seed) / RAND_MAX - 0.5;
+
+        /*** Lazy: only the non-zero features are touched. ***/
+        nzCount = nonzeros(x, CHECK_FEATURES, nz);
+        catchUpColumns(lazyW, CHECK_NODES, CHECK_NODES, nz, nzCount, &lazy);
+        updateColumns(
+            lazyW, x, nz, nzCount,
+            CHECK_NODES, CHECK_NODES,
+            d, gamma0, lazy.decay
+        );
+        advanceLazy(nz, nzCount, &lazy);
+
+        /*** Eager: every weight decays at every step. ***/
+        for(k = 0; k < CHECK_FEATURES; k++)
+            for(j = 0; j < CHECK_NODES; j++)
+                eagerW[k * CHECK_NODES + j] = (
+                    lazy.decay * eagerW[k * CHECK_NODES + j]
+                    - gamma0 * x[k] * d[j]
+                );
+    }
+    flushLazy(lazyW, CHECK_FEATURES, CHECK_NODES, &lazy);
+
+    for(k = 0; k < CHECK_FEATURES * CHECK_NODES; k++) {
+        diff = fabs(lazyW[k] - eagerW[k]);
+        if(diff > maxDiff)
+            maxDiff = diff;
+    }
+    printf("lazy decay: %d steps, max difference %g\n", CHECK_STEPS, maxDiff);
+    if(maxDiff > CHECK_TOLERANCE) {
+        fprintf(stderr, "check: lazy and eager decay differ\n");
+        return 1;
+    }
+    return 0;
+}
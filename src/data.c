@@ -20,6 +20,9 @@ $ gcc -Wall -lm -c -o data.o data.c
 
 #include "data.h"
 
+/*** Set once the generator is seeded by `setSeed`. ***/
+static int seeded = 0;
+
 
 /**
  * load
@@ -38,8 +41,8 @@ int load(
     double * const x,
     double * const y
 ) {
-    int i, val, count = 0;
-    char line[0x400], *token;
+    int ret, count = 0;
+    char line[0x400];
     FILE *file;
 
     /*** Open the file. ***/
@@ -57,32 +60,11 @@ int load(
             return -2;
         }
 
-        /*** Get the label from the line. ***/
-        token = strtok(line, " ");
-        if(token == NULL) {
-            fprintf(stderr, "error `load`: parsing label\n");
+        /*** Parse the example from the line. ***/
+        ret = parseExample(line, x + count * FEATURE_COUNT, y + count);
+        if(ret < 0) {
             fclose(file);
-            return -3;
-        }
-        y[count] = (atoi(token) == 0 ? -1 : 1);
-
-        /*** Reset the example features. ***/
-        x[count * FEATURE_COUNT] = 1;
-        for(i = 1; i < FEATURE_COUNT; i++)
-            x[count * FEATURE_COUNT + i] = 0;
-
-        /*** Parse example features from the line. ***/
-        while((token = strtok(NULL, " ")) != NULL) {
-            if(sscanf(token, "%d:%d", &i, &val) < 2) {
-                fprintf(
-                    stderr,
-                    "error `load`: unable to parse token: %s\n",
-                    token
-                );
-                fclose(file);
-                return -4;
-            }
-            x[count * FEATURE_COUNT + i] = 1.0 - exp((double)(-val));
+            return ret;
         }
 
         /*** Empty the string and update example count. ***/
@@ -95,6 +77,118 @@ int load(
     return count;
 }
 
+/**
+ * parseExample
+ *
+ * @summary
+ *   Parses one example in the format described by `load`.
+ *
+ * @description
+ *   `x_i` receives all FEATURE_COUNT features, bias first. `line` is modified.
+ *
+ * @returns
+ *   0 if successfully parsed; otherwise, a negative number.
+ */
+int parseExample(
+    char * const line,
+    double * const x_i,
+    double * const y_i
+) {
+    int i, val;
+    char *token;
+
+    /*** Get the label from the line. ***/
+    token = strtok(line, " ");
+    if(token == NULL) {
+        fprintf(stderr, "error `parseExample`: parsing label\n");
+        return -3;
+    }
+    (*y_i) = (atoi(token) == 0 ? -1 : 1);
+
+    /*** Reset the example features. ***/
+    x_i[0] = 1;
+    for(i = 1; i < FEATURE_COUNT; i++)
+        x_i[i] = 0;
+
+    /*** Parse example features from the line. ***/
+    while((token = strtok(NULL, " \n")) != NULL) {
+        if(sscanf(token, "%d:%d", &i, &val) < 2 ||
+            i < 1 || i >= FEATURE_COUNT) {
+            fprintf(
+                stderr,
+                "error `parseExample`: unable to parse token: %s\n",
+                token
+            );
+            return -4;
+        }
+        x_i[i] = 1.0 - exp((double)(-val));
+    }
+    return 0;
+}
+
+/**
+ * compact
+ *
+ * @summary
+ *   Drops the feature columns that are constant over a set of examples.
+ *
+ * @description
+ *   The bias column is always kept. The indices of the kept columns are
+ *   written into `featureMap` in ascending order and `x` is compacted in place
+ *   so that each example is `featureCount` features wide.
+ *
+ * @returns
+ *   The number of kept columns, `featureCount`.
+ */
+int compact(
+    const int count,
+    double * const x,
+    int * const featureMap
+) {
+    int i, j, featureCount = 1;
+
+    /*** Find the columns that differ from the first example. ***/
+    featureMap[0] = 0;
+    for(j = 1; j < FEATURE_COUNT; j++) {
+        for(i = 1; i < count; i++)
+            if(x[i * FEATURE_COUNT + j] != x[j])
+                break;
+        if(i < count)
+            featureMap[featureCount++] = j;
+    }
+
+    project(count, x, featureMap, featureCount);
+    return featureCount;
+}
+
+/**
+ * project
+ *   Compacts a set of examples in place to the columns of `featureMap`.
+ *   Because `featureMap` is ascending, no column is overwritten before it is
+ *   read.
+ */
+void project(
+    const int count,
+    double * const x,
+    const int * const featureMap,
+    const int featureCount
+) {
+    int i, j;
+    for(i = 0; i < count; i++)
+        for(j = 0; j < featureCount; j++)
+            x[i * featureCount + j] = x[i * FEATURE_COUNT + featureMap[j]];
+}
+
+/**
+ * setSeed
+ *   Makes `fillWeights` and `shuffle` draw from one stream seeded with `seed`
+ *   instead of reseeding with the time on every call.
+ */
+void setSeed(const unsigned int seed) {
+    srand(seed);
+    seeded = 1;
+}
+
 /**
  * fillWeights
  */
@@ -103,7 +197,8 @@ void fillWeights(
     double * const w
 ) {
     int i;
-    srand(time(NULL));
+    if(!seeded)
+        srand(time(NULL));
     for(i = 0; i < len; i++)
         w[i] = ((double)rand() / (double)RAND_MAX) * 2 - 1;
 }
@@ -111,19 +206,73 @@ void fillWeights(
 /**
  * shuffle
  */
-void shuffle(const int count, double * const x, double * const y) {
+void shuffle(
+    const int count,
+    const int featureCount,
+    double * const x,
+    double * const y
+) {
     int i, j, k;
     double tmpx, tmpy;
-    srand(time(NULL));
+    if(!seeded)
+        srand(time(NULL));
     for(i = 0; i < count; i++) {
         j = rand() % count;
-        for(k = 0; k < FEATURE_COUNT; k++) {
-            tmpx = x[i * FEATURE_COUNT + k];
-            x[i * FEATURE_COUNT + k] = x[j * FEATURE_COUNT + k];
-            x[j * FEATURE_COUNT + k] = tmpx;
+        for(k = 0; k < featureCount; k++) {
+            tmpx = x[i * featureCount + k];
+            x[i * featureCount + k] = x[j * featureCount + k];
+            x[j * featureCount + k] = tmpx;
         }
         tmpy = y[i];
         y[i] = y[j];
         y[j] = tmpy;
     }
 }
+
+/**
+ * seedWeights
+ *   Same as `fillWeights`, but draws from `seed` so that concurrent callers
+ *   get independent streams.
+ */
+void seedWeights(
+    const int len,
+    double * const w,
+    unsigned int * const seed
+) {
+    int i;
+    for(i = 0; i < len; i++)
+        w[i] = ((double)rand_r(seed) / (double)RAND_MAX) * 2 - 1;
+}
+
+/**
+ * bootstrap
+ *   Draws `count` example indices with replacement.
+ */
+void bootstrap(
+    const int count,
+    int * const index,
+    unsigned int * const seed
+) {
+    int i;
+    for(i = 0; i < count; i++)
+        index[i] = rand_r(seed) % count;
+}
+
+/**
+ * shuffleIndex
+ *   Shuffles example indices instead of the examples themselves, so that the
+ *   examples can be shared.
+ */
+void shuffleIndex(
+    const int count,
+    int * const index,
+    unsigned int * const seed
+) {
+    int i, j, tmp;
+    for(i = 0; i < count; i++) {
+        j = rand_r(seed) % count;
+        tmp = index[i];
+        index[i] = index[j];
+        index[j] = tmp;
+    }
+}
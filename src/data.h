@@ -14,5 +14,12 @@ Data management stuff.
 
 
 int load(const char * const, double * const, double * const);
+int parseExample(char * const, double * const, double * const);
+int compact(const int, double * const, int * const);
+void project(const int, double * const, const int * const, const int);
+void setSeed(const unsigned int);
 void fillWeights(const int, double * const);
-void shuffle(const int, double * const, double * const);
+void shuffle(const int, const int, double * const, double * const);
+void seedWeights(const int, double * const, unsigned int * const);
+void bootstrap(const int, int * const, unsigned int * const);
+void shuffleIndex(const int, int * const, unsigned int * const);
@@ -0,0 +1,315 @@
+/*******************************************************************************
+File: genkern.c
+Created by: agent
+Date created: October 18, 2026
+
+Generates training and prediction kernels specialized for fixed topologies.
+
+Each argument is a comma separated list of hidden layer widths, e.g.
+`256,64,16`; `0` is the network without hidden layers. The list may be prefixed
+with the number of input features, e.g. `131:180`, to make the first layer
+constant as well; otherwise, the kernel takes the number of input features at
+run time. The generated C source is written to stdout and calls the layer
+primitives of `kern.h` with constant widths and offsets so that the compiler
+can unroll and vectorize every loop.
+
+Compile with:
+```
+$ gcc -Wall -o genkern genkern.c
+$ ./genkern 0 180 256,64,16 131:180 > kernels.c
+```
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kern.h"
+
+/** Declarations **************************************************************/
+
+static int parseTopology(const char * const, int * const, int * const);
+static void emitFeatureCount(const int);
+static void emitTrain(
+    const char * const,
+    const int,
+    const int,
+    const int * const
+);
+static void emitPredict(
+    const char * const,
+    const int,
+    const int,
+    const int * const
+);
+
+/** Main **********************************************************************/
+
+int main(int argc, char **argv) {
+    int i, j, featureCount[argc], layerCount[argc];
+    int layerNodeCounts[argc][MAX_KERNEL_LAYERS];
+    char name[argc][0x100];
+
+    printf("/*** Generated by genkern; do not edit. ***/\n\n");
+    printf("#include <stddef.h>\n\n");
+    printf("#include \"kern.h\"\n");
+
+    for(i = 1; i < argc; i++) {
+        layerCount[i] = parseTopology(
+            argv[i],
+            &featureCount[i],
+            layerNodeCounts[i]
+        );
+        if(layerCount[i] < 0) {
+            fprintf(stderr, "error `genkern`: bad topology: %s\n", argv[i]);
+            return -1;
+        }
+        sprintf(name[i], "k%d", featureCount[i]);
+        for(j = 0; j < layerCount[i]; j++)
+            sprintf(name[i] + strlen(name[i]), "_%d", layerNodeCounts[i][j]);
+        emitTrain(name[i], featureCount[i], layerCount[i], layerNodeCounts[i]);
+        emitPredict(
+            name[i],
+            featureCount[i],
+            layerCount[i],
+            layerNodeCounts[i]
+        );
+    }
+
+    /*** Kernel table. ***/
+    printf("\nstatic const kernel kernels[] = {\n");
+    for(i = 1; i < argc; i++) {
+        printf("    { \"%s\", %d, %d, {", argv[i], featureCount[i],
+            layerCount[i]);
+        for(j = 0; j < layerCount[i]; j++)
+            printf("%s%d", j > 0 ? ", " : " ", layerNodeCounts[i][j]);
+        printf(" }, train%s, predict%s },\n", name[i], name[i]);
+    }
+    printf("    { NULL, 0, 0, { 0 }, NULL, NULL }\n};\n");
+
+    /*** Kernel lookup. ***/
+    printf(
+        "\nconst kernel *findKernel(\n"
+        "    const int featureCount,\n"
+        "    const int layerCount,\n"
+        "    const int * const layerNodeCounts\n"
+        ") {\n"
+        "    int i, j;\n"
+        "    const kernel *result = NULL;\n"
+        "    for(i = 0; kernels[i].name != NULL; i++) {\n"
+        "        if(kernels[i].layerCount != layerCount)\n"
+        "            continue;\n"
+        "        if(kernels[i].featureCount != 0 &&\n"
+        "            kernels[i].featureCount != featureCount)\n"
+        "            continue;\n"
+        "        for(j = 0; j < layerCount; j++)\n"
+        "            if(kernels[i].layerNodeCounts[j] != layerNodeCounts[j])\n"
+        "                break;\n"
+        "        if(j < layerCount)\n"
+        "            continue;\n"
+        "        /*** Prefer a constant number of input features. ***/\n"
+        "        if(result == NULL || kernels[i].featureCount != 0)\n"
+        "            result = &kernels[i];\n"
+        "    }\n"
+        "    return result;\n"
+        "}\n"
+    );
+
+    return 0;
+}
+
+/** Static functions **********************************************************/
+
+/**
+ * parseTopology
+ *   `featureCount` is set to 0 if the topology does not fix the number of
+ *   input features.
+ *
+ * @returns
+ *   The number of hidden layers if successfully parsed; otherwise, -1.
+ */
+static int parseTopology(
+    const char * const arg,
+    int * const featureCount,
+    int * const layerNodeCounts
+) {
+    int count = 0;
+    const char *token = arg;
+    char *end;
+    (*featureCount) = 0;
+    if(strchr(arg, ':') != NULL) {
+        (*featureCount) = (int)strtol(arg, &end, 10);
+        if((*end) != ':' || (*featureCount) < 1)
+            return -1;
+        token = end + 1;
+    }
+    if(strcmp(token, "0") == 0)
+        return 0;
+    while(count < MAX_KERNEL_LAYERS) {
+        layerNodeCounts[count] = (int)strtol(token, &end, 10);
+        if(end == token || layerNodeCounts[count] < 1)
+            return -1;
+        count++;
+        if((*end) == 0)
+            return count;
+        if((*end) != ',')
+            return -1;
+        token = end + 1;
+    }
+    return -1;
+}
+
+/**
+ * emitFeatureCount
+ *   Declares `f`, the number of input features, in the generated function.
+ */
+static void emitFeatureCount(const int featureCount) {
+    if(featureCount > 0)
+        printf("    const int f = %d;\n    (void)featureCount;\n",
+            featureCount);
+    else
+        printf("    const int f = featureCount;\n");
+}
+
+/**
+ * emitTrain
+ *   Weight offsets past the first layer are `layerNodeCounts[0] * f` plus
+ *   `wOffset`.
+ */
+static void emitTrain(
+    const char * const name,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+) {
+    int l, inCount = 0, wOffset[MAX_KERNEL_LAYERS + 1];
+    int zOffset[MAX_KERNEL_LAYERS + 1], dOffset[MAX_KERNEL_LAYERS + 1];
+
+    /*** Compute buffer offsets of each layer. ***/
+    wOffset[0] = zOffset[0] = dOffset[0] = 0;
+    for(l = 0; l < layerCount; l++) {
+        wOffset[l + 1] = wOffset[l] + layerNodeCounts[l] * inCount;
+        zOffset[l + 1] = zOffset[l] + layerNodeCounts[l] + 1;
+        dOffset[l + 1] = dOffset[l] + layerNodeCounts[l];
+        inCount = layerNodeCounts[l] + 1;
+    }
+
+    printf(
+        "\nstatic void train%s(\n"
+        "    const int featureCount,\n"
+        "    const double * const x_i,\n"
+        "    const double y_i,\n"
+        "    const double gamma0,\n"
+        "    double * const w,\n"
+        "    double * const z,\n"
+        "    double * const d,\n"
+        "    lazyDecay * const lazy\n"
+        ") {\n",
+        name
+    );
+    emitFeatureCount(featureCount);
+
+    /*** Perceptron. ***/
+    if(layerCount == 0) {
+        printf("    double dLy;\n    (void)z;\n    (void)d;\n");
+        printf("    dLy = dot(w, x_i, f) - y_i;\n");
+        printf("    updateLayer(w, x_i, f, 1, &dLy, gamma0, lazy->decay);\n");
+        printf("}\n");
+        return;
+    }
+
+    /*** Non-zero features of the example. ***/
+    printf("    int nz[f], nzCount;\n    double dLy;\n");
+    printf("    nzCount = nonzeros(x_i, f, nz);\n");
+    printf("    catchUpColumns(w, %d, %d, nz, nzCount, lazy);\n",
+        layerNodeCounts[0], layerNodeCounts[0]);
+
+    /*** Forward pass. ***/
+    for(l = 0; l < layerCount; l++) {
+        if(l == 0)
+            printf("    forwardInput(x_i, nz, nzCount, w, %d, z);\n",
+                layerNodeCounts[0]);
+        else
+            printf("    forwardLayer(z + %d, %d, w + %d * f + %d, %d, "
+                "z + %d);\n", zOffset[l - 1], layerNodeCounts[l - 1] + 1,
+                layerNodeCounts[0], wOffset[l], layerNodeCounts[l],
+                zOffset[l]);
+    }
+    printf("    dLy = dot(w + %d * f + %d, z + %d, %d) - y_i;\n",
+        layerNodeCounts[0], wOffset[layerCount], zOffset[layerCount - 1],
+        inCount);
+
+    /*** Deltas of the hidden layers, before any weight changes. ***/
+    for(l = layerCount - 1; l >= 0; l--) {
+        if(l == layerCount - 1)
+            printf("    backLayer(w + %d * f + %d, %d, 1, &dLy, z + %d, "
+                "d + %d);\n", layerNodeCounts[0], wOffset[l + 1],
+                layerNodeCounts[l] + 1, zOffset[l], dOffset[l]);
+        else
+            printf("    backLayer(w + %d * f + %d, %d, %d, d + %d, z + %d, "
+                "d + %d);\n", layerNodeCounts[0], wOffset[l + 1],
+                layerNodeCounts[l] + 1, layerNodeCounts[l + 1],
+                dOffset[l + 1], zOffset[l], dOffset[l]);
+    }
+
+    /*** Weight updates. ***/
+    printf("    updateColumns(w, x_i, nz, nzCount, %d, %d, d, gamma0, "
+        "lazy->decay);\n", layerNodeCounts[0], layerNodeCounts[0]);
+    for(l = 1; l < layerCount; l++)
+        printf("    updateLayer(w + %d * f + %d, z + %d, %d, %d, d + %d, "
+            "gamma0, lazy->decay);\n", layerNodeCounts[0], wOffset[l],
+            zOffset[l - 1], layerNodeCounts[l - 1] + 1, layerNodeCounts[l],
+            dOffset[l]);
+    printf("    updateLayer(w + %d * f + %d, z + %d, %d, 1, &dLy, gamma0, "
+        "lazy->decay);\n", layerNodeCounts[0], wOffset[layerCount],
+        zOffset[layerCount - 1], inCount);
+    printf("    advanceLazy(nz, nzCount, lazy);\n");
+
+    printf("}\n");
+}
+
+/**
+ * emitPredict
+ *   The hidden layers alternate between `zA` and `zB`. The first layer only
+ *   visits the non-zero features of the example.
+ */
+static void emitPredict(
+    const char * const name,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+) {
+    int l, inCount = 0, wOffset = 0;
+
+    printf(
+        "\nstatic double predict%s(\n"
+        "    const int featureCount,\n"
+        "    const double * const x_i,\n"
+        "    const double * const w,\n"
+        "    double * const zA,\n"
+        "    double * const zB\n"
+        ") {\n",
+        name
+    );
+    emitFeatureCount(featureCount);
+    if(layerCount == 0) {
+        printf("    (void)zA;\n    (void)zB;\n");
+        printf("    return dot(w, x_i, f);\n}\n");
+        return;
+    }
+
+    printf("    int nz[f], nzCount = nonzeros(x_i, f, nz);\n");
+    printf("    forwardInput(x_i, nz, nzCount, w, %d, zA);\n",
+        layerNodeCounts[0]);
+    inCount = layerNodeCounts[0] + 1;
+    for(l = 1; l < layerCount; l++) {
+        printf("    forwardLayer(%s, %d, w + %d * f + %d, %d, %s);\n",
+            l % 2 == 1 ? "zA" : "zB", inCount, layerNodeCounts[0], wOffset,
+            layerNodeCounts[l], l % 2 == 0 ? "zA" : "zB");
+        wOffset += layerNodeCounts[l] * inCount;
+        inCount = layerNodeCounts[l] + 1;
+    }
+    printf("    return dot(w + %d * f + %d, %s, %d);\n}\n", layerNodeCounts[0],
+        wOffset, layerCount % 2 == 1 ? "zA" : "zB", inCount);
+}
@@ -0,0 +1,427 @@
+/*******************************************************************************
+File: kern.h
+Created by: agent
+Date created: October 18, 2026
+
+Per-layer kernels of the artificial neural network.
+
+The layer primitives are `static inline` so that each caller gets its own copy.
+The generic loops in `seq.c` call them with run-time widths; the kernels
+generated by `genkern` call them with constant widths, which lets the compiler
+unroll and vectorize every loop for that topology.
+
+Weights are updated in place. Every delta is computed before any weight is
+changed, so back propagation still sees the weights of the forward pass.
+
+The first layer is stored by feature rather than by node, and both its forward
+pass and its update only visit the features that are non-zero in the example;
+see `forwardSparse` and `lazyDecay`. The weights of the other layers are stored
+by node.
+
+*******************************************************************************/
+
+#include <math.h>
+
+#define MAX_KERNEL_LAYERS 0x10
+
+/**
+ * lazyDecay
+ *   Bookkeeping for the sparse updates of the first layer. `decay` is the
+ *   factor applied to every weight at each step. The weights of a feature are
+ *   only written when an example has it non-zero, so `stamp[k]` records the
+ *   step through which the weights of feature `k` are up to date; the decay
+ *   they have missed since is applied when they are next touched, or by
+ *   `flushLazy`.
+ */
+typedef struct {
+    double decay;
+    long step;
+    long *stamp;
+} lazyDecay;
+
+/**
+ * kernel
+ *   A training step and a prediction specialized for a fixed topology. A
+ *   `featureCount` of 0 matches any number of input features.
+ */
+typedef struct {
+    const char *name;
+    int featureCount;
+    int layerCount;
+    int layerNodeCounts[MAX_KERNEL_LAYERS];
+    void (*train)(
+        const int featureCount,
+        const double * const x_i,
+        const double y_i,
+        const double gamma0,
+        double * const w,
+        double * const z,
+        double * const d,
+        lazyDecay * const lazy
+    );
+    double (*predict)(
+        const int featureCount,
+        const double * const x_i,
+        const double * const w,
+        double * const zA,
+        double * const zB
+    );
+} kernel;
+
+const kernel *findKernel(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+);
+
+/**
+ * dot
+ *   Keeps four partial sums so that the products can be vectorized without
+ *   reassociating the floating point additions.
+ */
+static inline double dot(
+    const double * const a,
+    const double * const b,
+    const int n
+) {
+    int i;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for(i = 0; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for(; i < n; i++)
+        s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * forwardRows
+ *   Computes the sigmoid outputs of `outCount` consecutive nodes from the
+ *   `inCount` features of the current layer.
+ */
+static inline void forwardRows(
+    const double * const in,
+    const int inCount,
+    const double * const w,
+    const int outCount,
+    double * const out
+) {
+    int j;
+    for(j = 0; j < outCount; j++)
+        out[j] = 1.0 / (1.0 + exp(-dot(w + j * inCount, in, inCount)));
+}
+
+/**
+ * forwardLayer
+ *   Computes the `outCount + 1` features of the next layer, including the bias
+ *   feature, from the `inCount` features of the current layer.
+ */
+static inline void forwardLayer(
+    const double * const in,
+    const int inCount,
+    const double * const w,
+    const int outCount,
+    double * const out
+) {
+    out[0] = 1;
+    forwardRows(in, inCount, w, outCount, out + 1);
+}
+
+/**
+ * backNodes
+ *   Computes the deltas `dIn[lo..hi)` of the hidden nodes feeding a layer from
+ *   the deltas `dOut` of its `outCount` nodes. `zIn` holds the sigmoid outputs
+ *   of the hidden nodes, bias first.
+ */
+static inline void backNodes(
+    const double * const w,
+    const int inCount,
+    const int outCount,
+    const double * const dOut,
+    const double * const zIn,
+    double * const dIn,
+    const int lo,
+    const int hi
+) {
+    int j, k;
+    for(k = lo; k < hi; k++)
+        dIn[k] = 0;
+    for(j = 0; j < outCount; j++)
+        for(k = lo; k < hi; k++)
+            dIn[k] += w[j * inCount + k + 1] * dOut[j];
+    for(k = lo; k < hi; k++)
+        dIn[k] *= zIn[k + 1] * (1.0 - zIn[k + 1]);
+}
+
+/**
+ * backLayer
+ *   Computes the deltas `dIn` of all `inCount - 1` hidden nodes feeding a
+ *   layer.
+ */
+static inline void backLayer(
+    const double * const w,
+    const int inCount,
+    const int outCount,
+    const double * const dOut,
+    const double * const zIn,
+    double * const dIn
+) {
+    backNodes(w, inCount, outCount, dOut, zIn, dIn, 0, inCount - 1);
+}
+
+/**
+ * updateLayer
+ *   Sets `w` to `decay * w - gamma0 * d * in` for each of the `outCount` rows.
+ */
+static inline void updateLayer(
+    double * const w,
+    const double * const in,
+    const int inCount,
+    const int outCount,
+    const double * const d,
+    const double gamma0,
+    const double decay
+) {
+    int j, k;
+    double g;
+    for(j = 0; j < outCount; j++) {
+        g = gamma0 * d[j];
+        for(k = 0; k < inCount; k++)
+            w[j * inCount + k] = decay * w[j * inCount + k] - g * in[k];
+    }
+}
+
+/**
+ * nonzeros
+ *   Writes the indices of the non-zero features of `x` into `index`. The scan
+ *   does not branch on the features, which are about as often zero as not.
+ *
+ * @returns
+ *   The number of non-zero features.
+ */
+static inline int nonzeros(
+    const double * const x,
+    const int n,
+    int * const index
+) {
+    int k, count = 0;
+    for(k = 0; k < n; k++) {
+        index[count] = k;
+        count += (x[k] != 0);
+    }
+    return count;
+}
+
+/**
+ * sumSparse
+ *   Computes the weighted sums of `outCount` consecutive nodes of the first
+ *   layer from the `count` non-zero features of `x` listed in `index`. The
+ *   first layer is stored by feature: the weights of feature `k` start at
+ *   `w + k * stride`, so each non-zero feature adds one contiguous row to the
+ *   sums of the nodes.
+ */
+static inline void sumSparse(
+    const double * const x,
+    const int * const index,
+    const int count,
+    const double * const w,
+    const int stride,
+    const int outCount,
+    double * const out
+) {
+    int i, j;
+    double a;
+    const double *row;
+    for(j = 0; j < outCount; j++)
+        out[j] = 0;
+    for(i = 0; i < count; i++) {
+        a = x[index[i]];
+        row = (w + index[i] * stride);
+        for(j = 0; j < outCount; j++)
+            out[j] += a * row[j];
+    }
+}
+
+/**
+ * forwardSparse
+ *   Computes the sigmoid outputs of the nodes summed by `sumSparse`.
+ */
+static inline void forwardSparse(
+    const double * const x,
+    const int * const index,
+    const int count,
+    const double * const w,
+    const int stride,
+    const int outCount,
+    double * const out
+) {
+    int j;
+    sumSparse(x, index, count, w, stride, outCount, out);
+    for(j = 0; j < outCount; j++)
+        out[j] = 1.0 / (1.0 + exp(-out[j]));
+}
+
+/**
+ * forwardInput
+ *   Computes the `outCount + 1` features of the first hidden layer, including
+ *   the bias feature.
+ */
+static inline void forwardInput(
+    const double * const x,
+    const int * const index,
+    const int count,
+    const double * const w,
+    const int outCount,
+    double * const out
+) {
+    out[0] = 1;
+    forwardSparse(x, index, count, w, outCount, outCount, out + 1);
+}
+
+/**
+ * catchUpColumns
+ *   Applies the decay that `outCount` consecutive nodes of the first layer have
+ *   missed in the weights of the `count` features of `index`. The stamps are
+ *   left to `advanceLazy`.
+ */
+static inline void catchUpColumns(
+    double * const w,
+    const int stride,
+    const int outCount,
+    const int * const index,
+    const int count,
+    const lazyDecay * const lazy
+) {
+    int i, j;
+    double f, *row;
+    if(lazy->decay == 1)
+        return;
+    for(i = 0; i < count; i++) {
+        if(lazy->stamp[index[i]] < lazy->step) {
+            f = pow(lazy->decay, (double)(lazy->step - lazy->stamp[index[i]]));
+            row = (w + index[i] * stride);
+            for(j = 0; j < outCount; j++)
+                row[j] *= f;
+        }
+    }
+}
+
+/**
+ * updateColumns
+ *   Sets the weights of the `count` features of `index` to
+ *   `decay * w - gamma0 * x * d` for `outCount` consecutive nodes of the first
+ *   layer. The gradient of the other weights is zero.
+ */
+static inline void updateColumns(
+    double * const w,
+    const double * const x,
+    const int * const index,
+    const int count,
+    const int stride,
+    const int outCount,
+    const double * const d,
+    const double gamma0,
+    const double decay
+) {
+    int i, j;
+    double g, *row;
+    for(i = 0; i < count; i++) {
+        g = gamma0 * x[index[i]];
+        row = (w + index[i] * stride);
+        for(j = 0; j < outCount; j++)
+            row[j] = decay * row[j] - g * d[j];
+    }
+}
+
+/**
+ * advanceLazy
+ *   Ends a step in which the `count` features of `index` were updated.
+ */
+static inline void advanceLazy(
+    const int * const index,
+    const int count,
+    lazyDecay * const lazy
+) {
+    int i;
+    lazy->step++;
+    for(i = 0; i < count; i++)
+        lazy->stamp[index[i]] = lazy->step;
+}
+
+/**
+ * flushLazy
+ *   Brings the weights of all `featureCount` features of the first layer, with
+ *   `outCount` nodes, up to date.
+ */
+static inline void flushLazy(
+    double * const w,
+    const int featureCount,
+    const int outCount,
+    lazyDecay * const lazy
+) {
+    int j, k;
+    double f;
+    for(k = 0; k < featureCount; k++) {
+        if(lazy->decay != 1 && lazy->stamp[k] < lazy->step) {
+            f = pow(lazy->decay, (double)(lazy->step - lazy->stamp[k]));
+            for(j = 0; j < outCount; j++)
+                w[k * outCount + j] *= f;
+        }
+        lazy->stamp[k] = lazy->step;
+    }
+}
+
+/**
+ * stepLinear
+ *   One stochastic gradient step of the model without hidden layers on the
+ *   `n` features of `x`. The update is fused with the running `sum` of the
+ *   weights of an averaged perceptron, unless `sum` is null. The update is
+ *   dense: after the training set is compacted, about half of the features of
+ *   an example are non-zero, and a contiguous vectorized pass beats a gather.
+ */
+static inline void stepLinear(
+    double * const w,
+    double * const sum,
+    const double * const x,
+    const int n,
+    const double y,
+    const double gamma0,
+    const double decay
+) {
+    int k;
+    const double g = gamma0 * (dot(w, x, n) - y);
+    if(sum == NULL)
+        for(k = 0; k < n; k++)
+            w[k] = decay * w[k] - g * x[k];
+    else
+        for(k = 0; k < n; k++) {
+            w[k] = decay * w[k] - g * x[k];
+            sum[k] += w[k];
+        }
+}
+
+/**
+ * averageCopies
+ *   Writes the mean of `copies` weight vectors, `stride` apart in `local`,
+ *   into `w[lo..hi)`.
+ */
+static inline void averageCopies(
+    const double * const local,
+    const int stride,
+    const int copies,
+    const int lo,
+    const int hi,
+    double * const w
+) {
+    int k, t;
+    for(k = lo; k < hi; k++)
+        w[k] = 0;
+    for(t = 0; t < copies; t++)
+        for(k = lo; k < hi; k++)
+            w[k] += local[t * stride + k];
+    for(k = lo; k < hi; k++)
+        w[k] /= copies;
+}
@@ -16,10 +16,13 @@ Memory management stuff.
 
 /**
  * init
+ *   `w` is sized for `modelCount` models of all FEATURE_COUNT features so that
+ *   it can hold the first layers before and after the examples are compacted.
  */
 int init(
+    const int modelCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     double **x,
     double **y,
     double **w
@@ -32,13 +35,46 @@ int init(
         cleanup(x, y, NULL);
         return -1;
     }
-    if(mallocWeights(layerCount, layerNodeCount, w) < 0) {
+    (*w) = (double *)malloc(
+        modelCount
+        * weightsSize(FEATURE_COUNT, layerCount, layerNodeCounts)
+        * sizeof(double)
+    );
+    if((*w) == NULL) {
+        perror("error `init`: not enough memory");
         cleanup(x, y, w);
         return -1;
     }
     return 0;
 }
 
+/**
+ * weightsSize
+ *   `featureCount` is the number of input features, including the bias.
+ *
+ * @returns
+ *   The number of weights of one model.
+ */
+int weightsSize(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+) {
+    int l, size = featureCount;
+    if(layerCount > 0) {
+        /*** featureCount * layerNodeCounts[0] for the first layer.     ***/
+        size = featureCount * layerNodeCounts[0];
+        /*** Hidden layer `l` has `layerNodeCounts[l]` output nodes,    ***/
+        /*** and we need `layerNodeCounts[l - 1] + 1` weights per node  ***/
+        /*** plus `layerNodeCounts[layerCount - 1] + 1` for the output  ***/
+        /*** node.                                                      ***/
+        for(l = 1; l < layerCount; l++)
+            size += layerNodeCounts[l] * (layerNodeCounts[l - 1] + 1);
+        size += layerNodeCounts[layerCount - 1] + 1;
+    }
+    return size;
+}
+
 /**
  * mallocWeights
  *
@@ -46,16 +82,13 @@ int init(
  *   The size of the weights memory space if successfully allocated; otherwise,
  *   -1.
  */
-int mallocWeights(const int layerCount, const int layerNodeCount, double **w) {
-    int size = FEATURE_COUNT;
-    if(layerCount > 0) {
-        /*** FEATURE_COUNT * layerNodeCount for the first layer.        ***/
-        size = FEATURE_COUNT * layerNodeCount;
-        /*** Each hidden layer has `nodeCount` output nodes, and we     ***/
-        /*** need `nodeCount + 1` weights per node plus                 ***/
-        /*** `layerNodeCount + 1` for the output node.                  ***/
-        size += ((layerCount - 1) * layerNodeCount + 1) * (layerNodeCount + 1);
-    }
+int mallocWeights(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    double **w
+) {
+    int size = weightsSize(featureCount, layerCount, layerNodeCounts);
     (*w) = (double *)malloc(size * sizeof(double));
     if((*w) == NULL) {
         perror("error `mallocWeights`: not enough memory");
@@ -69,11 +102,16 @@ int mallocWeights(const int layerCount, const int layerNodeCount, double **w) {
  *   `z` represents the intermediate values of the hidden layers for computing
  *   the prediction. If `layerCount` is 0, then `z` is effectively null.
  */
-int mallocz(const int layerCount, const int layerNodeCount, double **z) {
+int mallocz(
+    const int layerCount,
+    const int * const layerNodeCounts,
+    double **z
+) {
+    int l, size = 0;
     if(layerCount > 0) {
-        (*z) = (double *)malloc(
-            layerCount * (layerNodeCount + 1) * sizeof(double)
-        );
+        for(l = 0; l < layerCount; l++)
+            size += layerNodeCounts[l] + 1;
+        (*z) = (double *)malloc(size * sizeof(double));
         if((*z) == NULL) {
             perror("error `mallocz`: not enough memory");
             return -1;
@@ -84,6 +122,20 @@ int mallocz(const int layerCount, const int layerNodeCount, double **z) {
     return 0;
 }
 
+/**
+ * mallocStamps
+ *   `stamp` holds, for each input feature, the last training step in which its
+ *   column of the first layer was updated. All stamps start at 0.
+ */
+int mallocStamps(const int featureCount, long **stamp) {
+    (*stamp) = (long *)calloc(featureCount, sizeof(long));
+    if((*stamp) == NULL) {
+        perror("error `mallocStamps`: not enough memory");
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * freeptr
  */
@@ -116,3 +168,10 @@ void freeWeights(double **w) {
 void freez(double **z) {
     freeptr((void **)z);
 }
+
+/**
+ * freeStamps
+ */
+void freeStamps(long **stamp) {
+    freeptr((void **)stamp);
+}
@@ -8,15 +8,32 @@ Memory management stuff.
 *******************************************************************************/
 
 int init(
+    const int modelCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     double **x,
     double **y,
     double **w
 );
-int mallocWeights(const int layerCount, const int layerNodeCount, double **w);
-int mallocz(const int layerCount, const int layerNodeCount, double **z);
+int weightsSize(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts
+);
+int mallocWeights(
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    double **w
+);
+int mallocz(
+    const int layerCount,
+    const int * const layerNodeCounts,
+    double **z
+);
+int mallocStamps(const int featureCount, long **stamp);
 
 void cleanup(double **x, double **y, double **w);
 void freeWeights(double **w);
-void freez(double **z);
\ No newline at end of file
+void freez(double **z);
+void freeStamps(long **stamp);
\ No newline at end of file
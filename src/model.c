@@ -0,0 +1,197 @@
+/*******************************************************************************
+File: model.c
+Created by: agent
+Date created: October 18, 2026
+
+Model persistence stuff.
+
+A model is saved as text:
+```
+model <MODEL_VERSION>
+features <featureCount>
+<featureMap[0]> ... <featureMap[featureCount - 1]>
+layers <layerCount> <layerNodeCounts[0]> ... <layerNodeCounts[layerCount - 1]>
+weights <wlen>
+<w[0]>
+...
+```
+`featureMap` gives the column of the loaded examples for each input feature of
+the model, so examples must be projected with it before they are used.
+
+The version tells the layout of the weights. Since version 2, the first layer
+is stored by feature, so the weights of each input feature are consecutive;
+the other layers are stored by node. Files without a version store the first
+layer by node as well and are rejected, since they have as many weights and
+would otherwise be read transposed.
+
+A model is written to `<filePath>.tmp` and then renamed over `filePath`, so a
+reader never sees a partially written model.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data.h"
+#include "mem.h"
+#include "model.h"
+
+static int parseError(const char * const, FILE *, int **, double **);
+
+/**
+ * saveModel
+ *
+ * @returns
+ *   0 if successfully saved; otherwise, a negative number.
+ */
+int saveModel(
+    const char * const filePath,
+    const int featureCount,
+    const int * const featureMap,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w
+) {
+    int i, wlen = weightsSize(featureCount, layerCount, layerNodeCounts);
+    char *tmpPath;
+    FILE *file;
+
+    tmpPath = (char *)malloc(strlen(filePath) + sizeof(".tmp"));
+    if(tmpPath == NULL) {
+        perror("error `saveModel`: not enough memory");
+        return -1;
+    }
+    sprintf(tmpPath, "%s.tmp", filePath);
+
+    file = fopen(tmpPath, "w");
+    if(file == NULL) {
+        perror("error `saveModel`: opening file");
+        free(tmpPath);
+        return -2;
+    }
+
+    fprintf(file, "model %d\n", MODEL_VERSION);
+    fprintf(file, "features %d\n", featureCount);
+    for(i = 0; i < featureCount; i++)
+        fprintf(file, "%s%d", i > 0 ? " " : "", featureMap[i]);
+    fprintf(file, "\nlayers %d", layerCount);
+    for(i = 0; i < layerCount; i++)
+        fprintf(file, " %d", layerNodeCounts[i]);
+    fprintf(file, "\nweights %d\n", wlen);
+    for(i = 0; i < wlen; i++)
+        fprintf(file, "%.17g\n", w[i]);
+
+    if(fclose(file) != 0) {
+        perror("error `saveModel`: writing file");
+        free(tmpPath);
+        return -3;
+    }
+
+    /*** Publish the model. ***/
+    if(rename(tmpPath, filePath) != 0) {
+        perror("error `saveModel`: renaming file");
+        free(tmpPath);
+        return -4;
+    }
+    free(tmpPath);
+    return 0;
+}
+
+/**
+ * loadModel
+ *   `featureMap` must have room for FEATURE_COUNT columns. `layerNodeCounts`
+ *   and `w` are allocated and must be freed by the caller.
+ *
+ * @returns
+ *   The size of the weights if successfully loaded; otherwise, a negative
+ *   number.
+ */
+int loadModel(
+    const char * const filePath,
+    int * const featureCount,
+    int * const featureMap,
+    int * const layerCount,
+    int **layerNodeCounts,
+    double **w
+) {
+    int i, wlen, version;
+    FILE *file;
+
+    (*layerNodeCounts) = NULL;
+    (*w) = NULL;
+
+    file = fopen(filePath, "r");
+    if(file == NULL) {
+        perror("error `loadModel`: opening file");
+        return -1;
+    }
+
+    /*** Layout of the weights. ***/
+    if(fscanf(file, " model %d", &version) < 1 || version != MODEL_VERSION) {
+        fprintf(stderr, "error `loadModel`: %s is not a version %d model\n",
+            filePath, MODEL_VERSION);
+        fclose(file);
+        return -4;
+    }
+
+    /*** Feature map. ***/
+    if(fscanf(file, " features %d", featureCount) < 1 ||
+        (*featureCount) < 1 || (*featureCount) > FEATURE_COUNT)
+        return parseError(filePath, file, layerNodeCounts, w);
+    for(i = 0; i < (*featureCount); i++)
+        if(fscanf(file, "%d", &featureMap[i]) < 1 ||
+            featureMap[i] < 0 || featureMap[i] >= FEATURE_COUNT)
+            return parseError(filePath, file, layerNodeCounts, w);
+
+    /*** Topology. ***/
+    if(fscanf(file, " layers %d", layerCount) < 1 || (*layerCount) < 0)
+        return parseError(filePath, file, layerNodeCounts, w);
+    (*layerNodeCounts) = (int *)malloc(
+        ((*layerCount) > 0 ? (*layerCount) : 1) * sizeof(int)
+    );
+    if((*layerNodeCounts) == NULL) {
+        perror("error `loadModel`: not enough memory");
+        fclose(file);
+        return -2;
+    }
+    for(i = 0; i < (*layerCount); i++)
+        if(fscanf(file, "%d", &(*layerNodeCounts)[i]) < 1 ||
+            (*layerNodeCounts)[i] < 1)
+            return parseError(filePath, file, layerNodeCounts, w);
+
+    /*** Weights. ***/
+    wlen = mallocWeights((*featureCount), (*layerCount), (*layerNodeCounts), w);
+    if(wlen < 0) {
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        fclose(file);
+        return -2;
+    }
+    if(fscanf(file, " weights %d", &i) < 1 || i != wlen)
+        return parseError(filePath, file, layerNodeCounts, w);
+    for(i = 0; i < wlen; i++)
+        if(fscanf(file, "%lf", &(*w)[i]) < 1)
+            return parseError(filePath, file, layerNodeCounts, w);
+
+    fclose(file);
+    return wlen;
+}
+
+/**
+ * parseError
+ *   Releases whatever `loadModel` has allocated so far.
+ */
+static int parseError(
+    const char * const filePath,
+    FILE *file,
+    int **layerNodeCounts,
+    double **w
+) {
+    fprintf(stderr, "error `loadModel`: parsing %s\n", filePath);
+    free((*layerNodeCounts));
+    (*layerNodeCounts) = NULL;
+    freeWeights(w);
+    fclose(file);
+    return -3;
+}
@@ -0,0 +1,28 @@
+/*******************************************************************************
+File: model.h
+Created by: agent
+Date created: October 18, 2026
+
+Model persistence stuff.
+
+*******************************************************************************/
+
+/*** Version of the model file format ***/
+#define MODEL_VERSION 2
+
+int saveModel(
+    const char * const filePath,
+    const int featureCount,
+    const int * const featureMap,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w
+);
+int loadModel(
+    const char * const filePath,
+    int * const featureCount,
+    int * const featureMap,
+    int * const layerCount,
+    int **layerNodeCounts,
+    double **w
+);
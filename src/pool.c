@@ -0,0 +1,202 @@
+/*******************************************************************************
+File: pool.c
+Created by: agent
+Date created: October 18, 2026
+
+Persistent worker threads.
+
+The calling thread is thread 0 of the pool; `poolInit` starts the other
+`threadCount - 1` threads once and they wait for work between calls to
+`poolRun`. Waiting threads spin for a short while and then sleep on a futex, so
+that a barrier between two layers costs no system call when every thread
+arrives in time.
+
+Compile with:
+```
+$ gcc -Wall -pthread -c -o pool.o pool.c
+```
+
+*******************************************************************************/
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+#define SPIN_COUNT 0x1000
+
+/** Declarations **************************************************************/
+
+static void *work(void *);
+static void await(atomic_int * const, const int);
+static void wake(atomic_int * const);
+
+/** Static data ***************************************************************/
+
+static pthread_t *threads = NULL;
+static int threadTotal = 1;
+
+/*** Current task; `generation` is bumped each time one is posted. ***/
+static void (*task)(const int, const int, void *) = NULL;
+static void *taskArg = NULL;
+static atomic_int generation = 0;
+
+/*** Generation at which the current threads were started ***/
+static int firstGeneration = 0;
+
+/*** Barrier state ***/
+static atomic_int arrived = 0;
+static atomic_int phase = 0;
+
+/*** Number of threads asleep on a futex ***/
+static atomic_int sleepers = 0;
+
+/** Functions *****************************************************************/
+
+/**
+ * poolInit
+ *   The pool may be started again after `poolCleanup`, e.g. with a different
+ *   number of threads.
+ *
+ * @returns
+ *   0 if the threads were successfully started; otherwise, -1.
+ */
+int poolInit(const int threadCount) {
+    int i;
+    threadTotal = threadCount;
+    if(threadCount < 2)
+        return 0;
+    firstGeneration = atomic_load(&generation);
+    threads = (pthread_t *)malloc((threadCount - 1) * sizeof(pthread_t));
+    if(threads == NULL) {
+        perror("error `poolInit`: not enough memory");
+        threadTotal = 1;
+        return -1;
+    }
+    for(i = 1; i < threadCount; i++) {
+        if(pthread_create(&threads[i - 1], NULL, work, (void *)(long)i) != 0) {
+            perror("error `poolInit`: creating thread");
+            threadTotal = i;
+            poolCleanup();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * poolRun
+ *   Runs `task` on every thread of the pool and returns when all of them are
+ *   done.
+ */
+void poolRun(
+    void (*fn)(const int thread, const int threadCount, void *arg),
+    void *arg
+) {
+    task = fn;
+    taskArg = arg;
+    atomic_fetch_add(&generation, 1);
+    wake(&generation);
+    fn(0, threadTotal, arg);
+    poolBarrier();
+}
+
+/**
+ * poolBarrier
+ *   Waits until every thread of the pool has reached the barrier.
+ */
+void poolBarrier(void) {
+    int p;
+    if(threadTotal < 2)
+        return;
+    p = atomic_load(&phase);
+    if(atomic_fetch_add(&arrived, 1) == threadTotal - 1) {
+        atomic_store(&arrived, 0);
+        atomic_fetch_add(&phase, 1);
+        wake(&phase);
+    }
+    else
+        await(&phase, p);
+}
+
+/**
+ * poolRange
+ *   Splits `count` rows evenly between the threads of the pool.
+ */
+void poolRange(
+    const int count,
+    const int thread,
+    const int threadCount,
+    int * const lo,
+    int * const hi
+) {
+    (*lo) = (int)((long)count * thread / threadCount);
+    (*hi) = (int)((long)count * (thread + 1) / threadCount);
+}
+
+/**
+ * poolCleanup
+ */
+void poolCleanup(void) {
+    int i;
+    if(threads == NULL)
+        return;
+    task = NULL;
+    atomic_fetch_add(&generation, 1);
+    wake(&generation);
+    for(i = 1; i < threadTotal; i++)
+        pthread_join(threads[i - 1], NULL);
+    free(threads);
+    threads = NULL;
+    threadTotal = 1;
+}
+
+/** Static functions **********************************************************/
+
+/**
+ * work
+ *   Main loop of a pool thread.
+ */
+static void *work(void *arg) {
+    const int thread = (int)(long)arg;
+    int g = firstGeneration;
+    for(;;) {
+        await(&generation, g);
+        g = atomic_load(&generation);
+        if(task == NULL)
+            break;
+        task(thread, threadTotal, taskArg);
+        poolBarrier();
+    }
+    return NULL;
+}
+
+/**
+ * await
+ *   Waits until `word` no longer holds `value`.
+ */
+static void await(atomic_int * const word, const int value) {
+    int i;
+    for(i = 0; i < SPIN_COUNT; i++)
+        if(atomic_load(word) != value)
+            return;
+    atomic_fetch_add(&sleepers, 1);
+    while(atomic_load(word) == value)
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+    atomic_fetch_sub(&sleepers, 1);
+}
+
+/**
+ * wake
+ *   Wakes the threads asleep on `word`, if any.
+ */
+static void wake(atomic_int * const word) {
+    if(atomic_load(&sleepers) > 0)
+        syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
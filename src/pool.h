@@ -0,0 +1,23 @@
+/*******************************************************************************
+File: pool.h
+Created by: agent
+Date created: October 18, 2026
+
+Persistent worker threads.
+
+*******************************************************************************/
+
+int poolInit(const int threadCount);
+void poolRun(
+    void (*task)(const int thread, const int threadCount, void *arg),
+    void *arg
+);
+void poolBarrier(void);
+void poolRange(
+    const int count,
+    const int thread,
+    const int threadCount,
+    int * const lo,
+    int * const hi
+);
+void poolCleanup(void);
@@ -7,12 +7,29 @@ Sequential code of a fully connected artificial neural network.
 *******************************************************************************/
 
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "data.h"
+#include "kern.h"
 #include "mem.h"
+#include "model.h"
+#include "pool.h"
+#include "tune.h"
+
+/*** Number of examples, and minimum runs and seconds, timed for each ***/
+/*** candidate of `--tune`                                            ***/
+#define TUNE_SAMPLE 2000
+#define TUNE_RUNS 3
+#define TUNE_SECONDS 0.05
+
+/*** Snapshots of the weights that may wait for the evaluator ***/
+#define SNAPSHOT_SLOTS 2
 
 /** Declarations **************************************************************/
 
@@ -20,37 +37,112 @@ static int train(
     double * const x,
     double * const y,
     const int count,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     const int epochs,
     const double gamma0,
+    const double lambda,
     double * const w
 );
 static void test(
     const double * const x,
     const double * const y,
     const int count,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     const double * const w
 );
-static double propagate(
+static void score(
+    const double * const x,
+    const double * const y,
+    const int count,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
-    const double * const x_i,
+    const int * const layerNodeCounts,
     const double * const w,
-    const double * const z,
-    const int i,
-    const int j,
-    const int k
+    double * const accuracy,
+    double * const f1
+);
+static int startEvaluator(
+    const int featureCount,
+    const int * const featureMap,
+    const int layerCount,
+    const int * const layerNodeCounts
+);
+static int snapshotDue(const int);
+static void offerSnapshot(const double * const, const int);
+static int finishEvaluator(void);
+static void freeEvaluator(void);
+static void *evaluate(void *);
+static void trainExample(
+    const double * const x_i,
+    const double y_i,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
+);
+static void trainRows(const int, const int, void *);
+static void trainModels(const int, const int, void *);
+static int trainModel(void *, const int);
+static void trainShards(const int, const int, void *);
+static int autotune(
+    const double * const x,
+    const double * const y,
+    const int count,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double gamma0,
+    const double lambda,
+    double * const w,
+    int * const generic
+);
+static int learnOnline(
+    const char * const inPath,
+    const char * const outPath,
+    const int interval,
+    const double gamma0,
+    const double lambda,
+    const int generic
 );
 static double getPrediction(
     const double * const x_i,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w
+);
+static double getEnsemblePrediction(
+    const double * const x_i,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     const double * const w
 );
-static int parseArgs(const int, char **, int *, int *, int *, double *);
+static int parseLayerNodeCounts(const char * const, int **);
+static int parseArgs(
+    const int,
+    char **,
+    int *,
+    int **,
+    int *,
+    double *,
+    int *,
+    char **,
+    char **,
+    int *,
+    double *,
+    int *,
+    int *,
+    int *
+);
 static void printUsage(const char * const);
 
 /** Static data ***************************************************************/
@@ -60,85 +152,478 @@ static double *v = NULL;
 static double *u = NULL;
 static int vlen = 0;
 
+/*** First layer features of every model of an ensemble ***/
+static double *ze = NULL;
+
+/*** Kernel specialized for the topology, if any ***/
+static const kernel *kern = NULL;
+
+/*** Number of threads splitting the nodes of each layer ***/
+static int threadCount = 1;
+
+/*** Number of models of a bagged ensemble ***/
+static int modelCount = 1;
+
+/*** Examples each thread trains on between averages of the linear model; ***/
+/*** 0 averages once per epoch.                                          ***/
+static int mixInterval = 0;
+
+/*** Whether the linear model is an averaged perceptron ***/
+static int averaged = 0;
+
+/*** Seed of the random weights and shuffles; negative seeds with the time ***/
+static long seed = -1;
+
+/*** Epochs between the snapshots of the weights handed to the evaluator; ***/
+/*** 0 takes none.                                                        ***/
+static int evalInterval = 0;
+
+/*** Evaluations in a row without a better F1 before training stops; 0 ***/
+/*** never stops early.                                                ***/
+static int patience = 0;
+
+/*** Arguments of `trainRows` ***/
+typedef struct {
+    const double *x;
+    const double *y;
+    int count;
+    int featureCount;
+    int layerCount;
+    const int *layerNodeCounts;
+    double gamma0;
+    double *w;
+    double *z;
+    double *d;
+    lazyDecay *lazy;
+} trainArgs;
+
+/*** Arguments of `trainModels` ***/
+typedef struct {
+    const double *x;
+    const double *y;
+    int count;
+    int featureCount;
+    int layerCount;
+    const int *layerNodeCounts;
+    int epochs;
+    double gamma0;
+    double decay;
+    double *w;
+    unsigned int seed;
+    int ret;
+} ensembleArgs;
+
+/*** Arguments of `trainShards` ***/
+typedef struct {
+    const double *x;
+    const double *y;
+    int count;
+    int featureCount;
+    int stride;
+    double gamma0;
+    double decay;
+    double *w;
+    double *local;
+    double *sum;
+} mixArgs;
+
+/*** State of the thread that loads the test set while the classifier ***/
+/*** trains and then scores the snapshots of its weights.             ***/
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t posted;
+    pthread_cond_t freed;
+    double *x;
+    double *y;
+    int count;
+    int featureCount;
+    const int *featureMap;
+    int layerCount;
+    const int *layerNodeCounts;
+    int wlen;
+    double *queue[SNAPSHOT_SLOTS];
+    int epochs[SNAPSHOT_SLOTS];
+    int head;
+    int queued;
+    double *current;
+    int done;
+    atomic_int stop;
+    double bestF1;
+    int sinceBest;
+} evaluator;
+
+static evaluator evaluation;
+
 /** Main **********************************************************************/
 
 int main(int argc, char **argv) {
-    double *w, *x, *y, gamma0 = 0.01;
-    int ret, layerCount = 1, layerNodeCount = FEATURE_COUNT / 2, epochs = 100;
+    double *w, *x, *y, gamma0 = 0.01, lambda = 0, seconds, baseline = 0;
+    int i, ret, layerCount = 1, *layerNodeCounts = NULL, epochs = 100;
+    int scaling = 0, threads, average, count, tune = 0, manual = 0, every;
+    int generic = 0, featureCount, featureMap[FEATURE_COUNT], interval = 1000;
+    char *modelPath = NULL, *onlinePath = NULL, cachePath[TUNE_PATH_LENGTH];
+    const char *path;
+    double *xs, *ys;
+    struct timespec start, stop;
 
     /*** Parse command-line arguments. ***/
-    ret = parseArgs(argc, argv, &layerCount, &layerNodeCount, &epochs, &gamma0);
+    ret = parseArgs(
+        argc,
+        argv,
+        &layerCount,
+        &layerNodeCounts,
+        &epochs,
+        &gamma0,
+        &generic,
+        &modelPath,
+        &onlinePath,
+        &interval,
+        &lambda,
+        &scaling,
+        &tune,
+        &manual
+    );
     if(ret < 0) {
         return -1;
     }
+    if(seed >= 0)
+        setSeed((unsigned int)seed);
+
+    /*** Learn online, starting from an existing model. ***/
+    if(onlinePath != NULL) {
+        free(layerNodeCounts);
+        return learnOnline(
+            onlinePath,
+            modelPath,
+            interval,
+            gamma0,
+            lambda,
+            generic
+        );
+    }
+
     printf("epochs: %d\n", epochs);
     printf("layers: %d\n", layerCount);
-    printf("layer nodes: %d\n", layerNodeCount);
+    printf("layer nodes:");
+    for(i = 0; i < layerCount; i++)
+        printf("%s%d", i > 0 ? "," : " ", layerNodeCounts[i]);
+    printf("\n");
     printf("gamma: %f\n", gamma0);
+    printf("lambda: %f\n", lambda);
+    printf("models: %d\n", modelCount);
+    if(seed >= 0)
+        printf("seed: %ld\n", seed);
+    if(evalInterval > 0) {
+        printf("evaluation interval: %d\n", evalInterval);
+        printf("patience: %d\n", patience);
+    }
+    if(layerCount == 0) {
+        printf("mix interval: %d\n", mixInterval);
+        printf("averaged: %s\n", averaged ? "yes" : "no");
+    }
 
     /*** Initialize v and u. ***/
-    vlen = layerNodeCount + 1;
+    vlen = 1;
+    for(i = 0; i < layerCount; i++)
+        if(layerNodeCounts[i] + 1 > vlen)
+            vlen = layerNodeCounts[i] + 1;
     v = (double *)malloc(vlen * sizeof(double));
     u = (double *)malloc(vlen * sizeof(double));
     if(v == NULL) {
         perror("error `main`: not enough memory");
+        free(layerNodeCounts);
         return -2;
     }
     if(u == NULL) {
         perror("error `main`: not enough memory");
+        free(layerNodeCounts);
         free(v);
         return -2;
     }
+    if(modelCount > 1) {
+        ze = (double *)malloc(modelCount * vlen * sizeof(double));
+        if(ze == NULL) {
+            perror("error `main`: not enough memory");
+            free(layerNodeCounts);
+            free(v);
+            free(u);
+            return -2;
+        }
+    }
 
     /*** Allocate memory for examples. ***/
-    if(init(layerCount, layerNodeCount, &x, &y, &w) < 0) {
+    if(init(modelCount, layerCount, layerNodeCounts, &x, &y, &w) < 0) {
+        free(layerNodeCounts);
         free(v);
         free(u);
+        free(ze);
         return -2;
     }
 
     /*** Load training data. ***/
     ret = load(TRAIN_SET, x, y);
     if(ret < 0) {
+        free(layerNodeCounts);
         free(v);
         free(u);
+        free(ze);
         cleanup(&x, &y, &w);
         return -3;
     }
 
+    /*** Drop the feature columns that are constant over the training ***/
+    /*** set.                                                         ***/
+    featureCount = compact(ret, x, featureMap);
+    printf("features: %d\n", featureCount);
+
+    /*** Benchmark the kernels and thread counts for the topology, or ***/
+    /*** reuse the ones benchmarked before on this host.               ***/
+    if(modelCount == 1 && (tune || !manual)
+        && tuneCachePath(cachePath) == 0) {
+        if(tune) {
+            if(autotune(
+                x,
+                y,
+                ret,
+                featureCount,
+                layerCount,
+                layerNodeCounts,
+                gamma0,
+                lambda,
+                w,
+                &generic
+            ) < 0) {
+                free(layerNodeCounts);
+                free(v);
+                free(u);
+                free(ze);
+                cleanup(&x, &y, &w);
+                return -2;
+            }
+            if(saveTuning(
+                cachePath,
+                featureCount,
+                layerCount,
+                layerNodeCounts,
+                generic,
+                threadCount
+            ) == 0)
+                printf("tuning saved: %s\n", cachePath);
+        }
+        else if(loadTuning(
+            cachePath,
+            featureCount,
+            layerCount,
+            layerNodeCounts,
+            &generic,
+            &threads
+        ) > 0) {
+            /*** Without hidden layers, threads change the model; a ***/
+            /*** cache from before only the kernel was tuned may    ***/
+            /*** still list them.                                    ***/
+            if(layerCount > 0)
+                threadCount = threads;
+            printf("tuning loaded: %s\n", cachePath);
+        }
+    }
+
+    /*** Look up a kernel specialized for the topology. ***/
+    if(!generic)
+        kern = findKernel(featureCount, layerCount, layerNodeCounts);
+
+    /*** The threads of `trainRows` and of parameter mixing train ***/
+    /*** without the kernel; it is then only used for testing.     ***/
+    path = (kern != NULL ? kern->name : "generic");
+    if(modelCount == 1 && layerCount > 0 && threadCount > 1)
+        path = "generic rows";
+    else if(modelCount == 1 && layerCount == 0
+        && (threadCount > 1 || averaged))
+        path = "mixing";
+    printf("kernel: %s\n", path);
+    if(kern != NULL && path != kern->name)
+        printf("test kernel: %s\n", kern->name);
+    printf("threads: %d\n", threadCount);
+
+    /*** Load the test set on its own thread while the classifier ***/
+    /*** trains.                                                   ***/
+    if(startEvaluator(
+        featureCount,
+        featureMap,
+        layerCount,
+        layerNodeCounts
+    ) < 0) {
+        free(layerNodeCounts);
+        free(v);
+        free(u);
+        free(ze);
+        cleanup(&x, &y, &w);
+        return -2;
+    }
+
+    /*** Start the worker threads; an ensemble trains one model per ***/
+    /*** thread.                                                    ***/
+    if(poolInit(modelCount > 1 ? modelCount : threadCount) < 0) {
+        finishEvaluator();
+        freeEvaluator();
+        free(layerNodeCounts);
+        free(v);
+        free(u);
+        free(ze);
+        cleanup(&x, &y, &w);
+        return -2;
+    }
+
+    /*** Time the single-threaded loop as the baseline of the scaling ***/
+    /*** report; the classifier is trained again below, from the same ***/
+    /*** examples and seed.                                           ***/
+    if(scaling) {
+        count = ret;
+        xs = (double *)malloc(count * featureCount * sizeof(double));
+        ys = (double *)malloc(count * sizeof(double));
+        if(xs == NULL || ys == NULL) {
+            perror("error `main`: not enough memory");
+            free(xs);
+            free(ys);
+            poolCleanup();
+            finishEvaluator();
+            freeEvaluator();
+            free(layerNodeCounts);
+            free(v);
+            free(u);
+            free(ze);
+            cleanup(&x, &y, &w);
+            return -2;
+        }
+        memcpy(xs, x, count * featureCount * sizeof(double));
+        memcpy(ys, y, count * sizeof(double));
+        threads = threadCount;
+        average = averaged;
+        every = evalInterval;
+        threadCount = 1;
+        averaged = 0;
+        evalInterval = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ret = train(
+            x,
+            y,
+            count,
+            featureCount,
+            layerCount,
+            layerNodeCounts,
+            epochs,
+            gamma0,
+            lambda,
+            w
+        );
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        threadCount = threads;
+        averaged = average;
+        evalInterval = every;
+        memcpy(x, xs, count * featureCount * sizeof(double));
+        memcpy(y, ys, count * sizeof(double));
+        free(xs);
+        free(ys);
+        if(seed >= 0)
+            setSeed((unsigned int)seed);
+        if(ret < 0) {
+            poolCleanup();
+            finishEvaluator();
+            freeEvaluator();
+            free(layerNodeCounts);
+            free(v);
+            free(u);
+            free(ze);
+            cleanup(&x, &y, &w);
+            return -4;
+        }
+        baseline = (stop.tv_sec - start.tv_sec)
+            + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+        printf("baseline time: %f s\n", baseline);
+        ret = count;
+    }
+
     /*** Train classifier. ***/
+    clock_gettime(CLOCK_MONOTONIC, &start);
     ret = train(
         x,
         y,
         ret,
+        featureCount,
         layerCount,
-        layerNodeCount,
+        layerNodeCounts,
         epochs,
         gamma0,
+        lambda,
         w
     );
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    poolCleanup();
+
+    /*** Wait for the evaluator to score the last snapshot. ***/
+    count = finishEvaluator();
     if(ret < 0) {
+        freeEvaluator();
+        free(layerNodeCounts);
         free(v);
         free(u);
+        free(ze);
         cleanup(&x, &y, &w);
         return -4;
     }
 
-    /*** Load test data. ***/
-    ret = load(TEST_SET, x, y);
-    if(ret < 0) {
+    seconds = (stop.tv_sec - start.tv_sec)
+        + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("train time: %f s\n", seconds);
+    if(scaling)
+        printf("speedup: %f over 1 thread\n", baseline / seconds);
+
+    /*** Save the trained model. ***/
+    if(modelPath != NULL && saveModel(
+        modelPath,
+        featureCount,
+        featureMap,
+        layerCount,
+        layerNodeCounts,
+        w
+    ) < 0) {
+        freeEvaluator();
+        free(layerNodeCounts);
+        free(v);
+        free(u);
+        free(ze);
+        cleanup(&x, &y, &w);
+        return -5;
+    }
+
+    /*** The test set was loaded by the evaluator. ***/
+    if(count < 0) {
+        freeEvaluator();
+        free(layerNodeCounts);
         free(v);
         free(u);
+        free(ze);
         cleanup(&x, &y, &w);
-        return ret;
+        return count;
     }
 
     /*** Test classifier accuracy. ***/
-    test(x, y, ret, layerCount, layerNodeCount, w);
+    test(
+        evaluation.x,
+        evaluation.y,
+        count,
+        featureCount,
+        layerCount,
+        layerNodeCounts,
+        w
+    );
 
     /*** Cleanup memory from examples. ***/
+    freeEvaluator();
+    free(layerNodeCounts);
     free(v);
     free(u);
+    free(ze);
     cleanup(&x, &y, &w);
 
     return 0;
@@ -151,149 +636,214 @@ int main(int argc, char **argv) {
  *
  * @summary
  *   Trains the weights of the artificial neural network classifier.
+ *
+ * @description
+ *   `lambda` is the L2 regularization of the weights; each step decays them by
+ *   `1 - gamma0 * lambda` before the gradient step.
  */
 static int train(
     double * const x,
     double * const y,
     const int count,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     const int epochs,
     const double gamma0,
+    const double lambda,
     double * const w
 ) {
-    int e, i, j, k, l, wlen;
-    double *x_i, *wSwap1, *wSwap2, *wptr1, *wptr2, *z, *zcur, *znxt;
-    double dot, yp, dLy;
+    int e, i, j, wlen;
+    double *x_i, *z, *d;
+    double yp, dLy;
+    lazyDecay lazy;
+    trainArgs args;
+    ensembleArgs ensemble;
+    mixArgs mix;
 
-    /*** Allocate swap weights. ***/
-    wlen = mallocWeights(layerCount, layerNodeCount, &wSwap2);
-    if(wlen < 0)
-        return wlen;
+    /*** Train each model of an ensemble on its own thread. ***/
+    if(modelCount > 1) {
+        ensemble.x = x;
+        ensemble.y = y;
+        ensemble.count = count;
+        ensemble.featureCount = featureCount;
+        ensemble.layerCount = layerCount;
+        ensemble.layerNodeCounts = layerNodeCounts;
+        ensemble.epochs = epochs;
+        ensemble.gamma0 = gamma0;
+        ensemble.decay = 1 - gamma0 * lambda;
+        ensemble.w = w;
+        ensemble.seed = (unsigned int)(seed >= 0 ? seed : time(NULL));
+        ensemble.ret = 0;
+        poolRun(trainModels, &ensemble);
+        return ensemble.ret;
+    }
 
-    /*** Allocate z. ***/
-    i = mallocz(layerCount, layerNodeCount, &z);
+    /*** Allocate z, the deltas of the hidden nodes and the stamps of ***/
+    /*** the input columns.                                           ***/
+    i = mallocz(layerCount, layerNodeCounts, &z);
+    if(i < 0)
+        return i;
+    i = mallocz(layerCount, layerNodeCounts, &d);
     if(i < 0) {
-        freeWeights(&wSwap2);
+        freez(&z);
         return i;
     }
+    i = mallocStamps(featureCount, &lazy.stamp);
+    if(i < 0) {
+        freez(&z);
+        freez(&d);
+        return i;
+    }
+    lazy.decay = 1 - gamma0 * lambda;
+    lazy.step = 0;
 
     /*** Initialize weights. ***/
+    wlen = weightsSize(featureCount, layerCount, layerNodeCounts);
     fillWeights(wlen, w);
-    wSwap1 = w;
 
-    if(layerCount > 0) {
+    /*** Split the nodes of each layer between the worker threads. ***/
+    if(layerCount > 0 && threadCount > 1) {
+        args.x = x;
+        args.y = y;
+        args.count = count;
+        args.featureCount = featureCount;
+        args.layerCount = layerCount;
+        args.layerNodeCounts = layerNodeCounts;
+        args.gamma0 = gamma0;
+        args.w = w;
+        args.z = z;
+        args.d = d;
+        args.lazy = &lazy;
+
         /*** Train over epochs. ***/
-        for(e = 0; e < epochs; e++) {
+        for(e = 0; e < epochs && !atomic_load(&evaluation.stop); e++) {
 
             /*** Shuffle examples. ***/
-            shuffle(count, x, y);
+            shuffle(count, featureCount, x, y);
+
+/** Parallel 1: Neural Network ************************************************/
+
+            poolRun(trainRows, &args);
+
+/******************************************************************************/
+
+            /*** Hand a snapshot of the weights to the evaluator. ***/
+            if(snapshotDue(e + 1)) {
+                flushLazy(w, featureCount, layerNodeCounts[0], &lazy);
+                offerSnapshot(w, e + 1);
+            }
+        }
+    }
+
+    else if(layerCount > 0) {
+        /*** Train over epochs. ***/
+        for(e = 0; e < epochs && !atomic_load(&evaluation.stop); e++) {
+
+            /*** Shuffle examples. ***/
+            shuffle(count, featureCount, x, y);
 
 /** Sequential 1: Neural Network **********************************************/
 
             for(i = 0; i < count; i++) {
-                x_i = (x + (i * FEATURE_COUNT));
-                wptr1 = wSwap1;
-                zcur = x_i;
-                znxt = z;
+                x_i = (x + (i * featureCount));
 
-                /*** Compute yp and remember hidden layer features. ***/
+                /*** Update weights using back propagation. ***/
+                if(kern != NULL)
+                    kern->train(
+                        featureCount, x_i, y[i],
+                        gamma0, w, z, d, &lazy
+                    );
+                else
+                    trainExample(
+                        x_i, y[i],
+                        featureCount, layerCount, layerNodeCounts,
+                        gamma0, w, z, d, &lazy
+                    );
+            }
 
-                /* First layer. */
-                znxt[0] = 1;
-                for(j = 1; j < layerNodeCount + 1; j++) {
-                    dot = 0;
-                    for(k = 0; k < FEATURE_COUNT; k++)
-                        dot += wptr1[k] * zcur[k];
-                    znxt[j] = 1.0 / (1.0 + exp(-dot));
-                    wptr1 = (wptr1 + FEATURE_COUNT);
-                }
-                zcur = znxt;
-                znxt = (znxt + layerNodeCount + 1);
-
-                /* Remaining layers. */
-                for(j = 1; j < layerCount; j++) {
-                    znxt[0] = 1;
-                    for(k = 1; k < layerNodeCount + 1; k++) {
-                        dot = 0;
-                        for(l = 0; l < layerNodeCount + 1; l++)
-                            dot += wptr1[l] * zcur[l];
-                        znxt[k] = 1.0 / (1.0 + exp(-dot));
-                        wptr1 = (wptr1 + layerNodeCount + 1);
-                    }
-                    zcur = znxt;
-                    znxt = (znxt + layerNodeCount + 1);
-                }
+/******************************************************************************/
 
-                yp = 0;
-                for(j = 0; j < layerNodeCount + 1; j++)
-                    yp += wptr1[j] * zcur[j];
-                // zcur = znxt;
-                znxt = (zcur - layerNodeCount - 1);
-                
-                /*** Save derivitive of square loss. ***/
-                dLy = yp - y[i];
-                
-                /*** Update weights using back propagation. ***/
+            /*** Hand a snapshot of the weights to the evaluator. ***/
+            if(snapshotDue(e + 1)) {
+                flushLazy(w, featureCount, layerNodeCounts[0], &lazy);
+                offerSnapshot(w, e + 1);
+            }
+        }
+    }
 
-                /* Output layer. */
-                l = layerCount;
-                wptr2 = (
-                    wSwap2 + 
-                    layerNodeCount * FEATURE_COUNT + 
-                    (layerCount - 1) * layerNodeCount * (layerNodeCount + 1)
-                );
-                for(j = 0; j < layerNodeCount + 1; j++) {
-                    wptr2[j] = wptr1[j] - gamma0 * dLy * zcur[j];
-                    zcur[j] *= (1.0 - zcur[j]);
-                }
+    /*** Without hidden layers, each thread trains its own copy of the ***/
+    /*** weights on a shard of the examples, and the copies are        ***/
+    /*** averaged.                                                     ***/
+    else if(threadCount > 1 || averaged) {
+        mix.x = x;
+        mix.y = y;
+        mix.count = count;
+        mix.featureCount = featureCount;
+        mix.gamma0 = gamma0;
+        mix.decay = lazy.decay;
+        mix.w = w;
 
-                /* Hidden layers. */
-                zcur = znxt;
-                znxt = (znxt - layerNodeCount - 1);
-                wptr1 = (wptr1 - layerNodeCount * (layerNodeCount + 1));
-                wptr2 = (wptr2 - layerNodeCount * (layerNodeCount + 1));
-                for(l = l - 1; l > 0; l--) {
-                    for(j = 0; j < layerNodeCount; j++) {
-                        for(k = 0; k < layerNodeCount + 1; k++)
-                            wptr2[j * (layerNodeCount + 1) + k]
-                                = wptr1[j * (layerNodeCount + 1) + k]
-                                - gamma0 * dLy * propagate(
-                                layerCount, layerNodeCount,
-                                x_i, wSwap1, z,
-                                l, j, k
-                            );
-                        for(k = 0; k < layerNodeCount + 1; k++)
-                            zcur[k] *= (1.0 - zcur[k]);
-                    }
-                    zcur = znxt;
-                    znxt = (znxt - layerNodeCount - 1);
-                    wptr1 = (wptr1 - layerNodeCount * (layerNodeCount + 1));
-                    wptr2 = (wptr2 - layerNodeCount * (layerNodeCount + 1));
-                }
+        /*** Pad each copy to a cache line so the threads do not share ***/
+        /*** one.                                                     ***/
+        mix.stride = (featureCount + 7) & ~7;
+        mix.local = (double *)malloc(
+            threadCount * mix.stride * sizeof(double)
+        );
+        mix.sum = NULL;
+        if(averaged)
+            mix.sum = (double *)calloc(
+                threadCount * mix.stride,
+                sizeof(double)
+            );
+        if(mix.local == NULL || (averaged && mix.sum == NULL)) {
+            perror("error `train`: not enough memory");
+            free(mix.local);
+            free(mix.sum);
+            freez(&z);
+            freez(&d);
+            freeStamps(&lazy.stamp);
+            return -1;
+        }
 
-                /* Input layer. */
-                for(j = 0; j < layerNodeCount; j++) {
-                    for(k = 0; k < FEATURE_COUNT; k++) {
-                        wSwap2[j * FEATURE_COUNT + k]
-                            = wSwap1[j * FEATURE_COUNT + k]
-                            - gamma0 * dLy * propagate(
-                                layerCount, layerNodeCount,
-                                x_i, wSwap1, z,
-                                0, j, k
-                            );
-                    }
-                }
-                
-                /*** Swap weight buffers. ***/
-                wptr1 = wSwap1;
-                wSwap1 = wSwap2;
-                wSwap2 = wptr1;
-            }
+        /*** Train over epochs. ***/
+        for(e = 0; e < epochs && !atomic_load(&evaluation.stop); e++) {
+            /*** Shuffle examples. ***/
+            shuffle(count, featureCount, x, y);
+
+/** Parallel 2: Parameter mixing **********************************************/
+
+            poolRun(trainShards, &mix);
 
 /******************************************************************************/
 
+            /*** Hand a snapshot of the weights to the evaluator; the ***/
+            /*** copies are free between epochs, so the first holds    ***/
+            /*** the averaged perceptron so far.                       ***/
+            if(snapshotDue(e + 1) && averaged) {
+                averageCopies(
+                    mix.sum, mix.stride, threadCount,
+                    0, featureCount, mix.local
+                );
+                for(j = 0; j < featureCount; j++)
+                    mix.local[j] *= (
+                        (double)threadCount / ((double)count * (e + 1))
+                    );
+                offerSnapshot(mix.local, e + 1);
+            }
+            else if(snapshotDue(e + 1))
+                offerSnapshot(w, e + 1);
+        }
+
+        /*** The averaged perceptron is the mean of the weights after ***/
+        /*** every step of every thread.                             ***/
+        if(averaged) {
+            averageCopies(mix.sum, mix.stride, threadCount, 0, featureCount, w);
+            for(j = 0; j < featureCount; j++)
+                w[j] *= (double)threadCount / ((double)count * e);
         }
+        free(mix.local);
+        free(mix.sum);
     }
 
     /*** If there are no hidden layers, then training amounts to the ***/
@@ -301,47 +851,58 @@ static int train(
     else {
 
         /*** Train over epochs. ***/
-        for(e = 0; e < epochs; e++) {
+        for(e = 0; e < epochs && !atomic_load(&evaluation.stop); e++) {
             /*** Shuffle examples. ***/
-            shuffle(count, x, y);
+            shuffle(count, featureCount, x, y);
 
 /** Sequential 2: Simple dot product ******************************************/
 
             for(i = 0; i < count; i++) {
-                x_i = (x + (i * FEATURE_COUNT));
+                x_i = (x + (i * featureCount));
 
-                /*** Compute dot product. ***/
-                yp = 0;
-                for(j = 0; j < FEATURE_COUNT; j++)
-                    yp += wSwap1[j] * x_i[j];
+                if(kern != NULL)
+                    kern->train(
+                        featureCount, x_i, y[i],
+                        gamma0, w, z, d, &lazy
+                    );
+                else {
+                    /*** Compute dot product. ***/
+                    yp = 0;
+                    for(j = 0; j < featureCount; j++)
+                        yp += w[j] * x_i[j];
 
-                /*** Save derivitive of square loss. ***/
-                dLy = yp - y[i];
+                    /*** Save derivitive of square loss. ***/
+                    dLy = yp - y[i];
 
-                /*** Update weights. ***/
-                for(j = 0; j < FEATURE_COUNT; j++)
-                    wSwap2[j] = wSwap1[j] - gamma0 * dLy * x_i[j];
-
-                /*** Swap weight buffers. ***/
-                wptr1 = wSwap1;
-                wSwap1 = wSwap2;
-                wSwap2 = wptr1;
+                    /*** Update weights. ***/
+                    for(j = 0; j < featureCount; j++)
+                        w[j] = lazy.decay * w[j] - gamma0 * dLy * x_i[j];
+                }
             }
 
 /******************************************************************************/
 
+            /*** Hand a snapshot of the weights to the evaluator. ***/
+            if(snapshotDue(e + 1))
+                offerSnapshot(w, e + 1);
         }
     }
 
+    if(e < epochs)
+        printf("stopped early: %d epochs\n", e);
+
+    /*** Apply the decay the input columns have missed. ***/
+    flushLazy(
+        w,
+        featureCount,
+        layerCount > 0 ? layerNodeCounts[0] : 1,
+        &lazy
+    );
+
     /*** Cleanup memory. ***/
-    if(w == wSwap1)
-        freeWeights(&wSwap2);
-    else {
-        /*** Copy trained weights into w. ***/
-        memcpy(w, wSwap1, wlen * sizeof(double));
-        freeWeights(&wSwap1);
-    }
     freez(&z);
+    freez(&d);
+    freeStamps(&lazy.stamp);
 
     return 0;
 }
@@ -353,13 +914,44 @@ static void test(
     const double * const x,
     const double * const y,
     const int count,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
+    const int * const layerNodeCounts,
     const double * const w
+) {
+    double accuracy, f1;
+    score(
+        x,
+        y,
+        count,
+        featureCount,
+        layerCount,
+        layerNodeCounts,
+        w,
+        &accuracy,
+        &f1
+    );
+    printf("accuracy: %f\nf1: %f\n", accuracy, f1);
+}
+
+/**
+ * score
+ *   Computes the accuracy and F1 of the classifier on a set of examples.
+ */
+static void score(
+    const double * const x,
+    const double * const y,
+    const int count,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w,
+    double * const accuracy,
+    double * const f1
 ) {
     int i;
     const double *x_i = x;
-    double y_i, y_p, p, r, f1, accuracy;
+    double y_i, y_p, p, r;
     /*** True/False Positive/Negative ***/
     int tp = 0;
     int fp = 0;
@@ -368,7 +960,7 @@ static void test(
 
     for(i = 0; i < count; i++) {
         y_i = y[i];
-        y_p = getPrediction(x_i, layerCount, layerNodeCount, w);
+        y_p = getPrediction(x_i, featureCount, layerCount, layerNodeCounts, w);
         if(y_i > 0 && y_p > 0)
             tp++;
         else if(y_i > 0 && y_p < 0)
@@ -377,16 +969,16 @@ static void test(
             fp++;
         else
             tn++;
-        x_i = (x_i + FEATURE_COUNT);
+        x_i = (x_i + featureCount);
     }
 
     p = 0;
     r = 0;
-    f1 = 0;
+    (*f1) = 0;
     if(tp > 0) {
         p = (double)tp / (double)(tp + fp);
         r = (double)tp / (double)(tp + fn);
-        f1 = 2 * p * r / (p + r);
+        (*f1) = 2 * p * r / (p + r);
     }
     else {
         if(fp == 0)
@@ -395,113 +987,1127 @@ static void test(
             r = 1;
     }
 
-    accuracy = (double)(tp + tn) / (double)count;
-    printf("accuracy: %f\nf1: %f\n", accuracy, f1);
+    (*accuracy) = (double)(tp + tn) / (double)count;
 }
 
 /**
- * propagate
+ * startEvaluator
+ *
+ * @summary
+ *   Starts the thread that loads the test set and scores the snapshots of the
+ *   weights taken while training.
+ *
+ * @description
+ *   The test set is loaded into its own buffers, so it is ready when training
+ *   ends. With an evaluation interval, the trainer copies its weights into
+ *   the `queue` every `evalInterval` epochs, and the evaluator swaps the
+ *   oldest with `current` to score it while the trainer moves on. The trainer
+ *   only waits if all SNAPSHOT_SLOTS snapshots are still queued, e.g. while
+ *   the test set is loading, so no point of the learning curve is lost. The
+ *   evaluator is the only thread that predicts while the classifier trains,
+ *   so it may use `v` and `u`.
+ *
+ * @returns
+ *   0 if the thread was successfully started; otherwise, a negative number.
  */
-static double propagate(
+static int startEvaluator(
+    const int featureCount,
+    const int * const featureMap,
     const int layerCount,
-    const int layerNodeCount,
-    const double * const x_i,
-    const double * const w,
-    const double * const z,
-    const int i,
-    const int j,
-    const int k
+    const int * const layerNodeCounts
 ) {
-    int j1;
-    int wl = layerNodeCount * FEATURE_COUNT +
-        i * layerNodeCount * (layerNodeCount + 1);
-    double result = 0;
-    const double * l = (i > 0 ? (z + (i - 1) * (layerNodeCount + 1)) : x_i);
-
-    if(i + 1 < layerCount) {
-        for(j1 = 0; j1 < layerNodeCount; j1++)
-            result += l[k] * w[wl + j1 * (layerNodeCount + 1) + j + 1]
-                * propagate(
-                    layerCount, layerNodeCount,
-                    x_i, w, z,
-                    i + 1, j1, j + 1
-                );
+    evaluator * const ev = &evaluation;
+    int i;
+
+    ev->count = 0;
+    ev->wlen = 0;
+    ev->featureCount = featureCount;
+    ev->featureMap = featureMap;
+    ev->layerCount = layerCount;
+    ev->layerNodeCounts = layerNodeCounts;
+    for(i = 0; i < SNAPSHOT_SLOTS; i++)
+        ev->queue[i] = NULL;
+    ev->current = NULL;
+    ev->head = 0;
+    ev->queued = 0;
+    ev->done = 0;
+    atomic_store(&ev->stop, 0);
+    ev->bestF1 = -1;
+    ev->sinceBest = 0;
+
+    /*** Allocate the test set and the snapshots. ***/
+    ev->x = (double *)malloc(MAX_EXAMPLES * FEATURE_COUNT * sizeof(double));
+    ev->y = (double *)malloc(MAX_EXAMPLES * sizeof(double));
+    if(ev->x == NULL || ev->y == NULL) {
+        perror("error `startEvaluator`: not enough memory");
+        freeEvaluator();
+        return -1;
     }
-    else {
-        wl += layerNodeCount * (layerNodeCount + 1);
-        result = l[k]
-            * w[wl + j + 1]
-            * z[(i + 1) * (layerNodeCount + 1) + j + 1];
+    if(evalInterval > 0) {
+        ev->wlen = mallocWeights(
+            featureCount,
+            layerCount,
+            layerNodeCounts,
+            &ev->current
+        );
+        for(i = 0; i < SNAPSHOT_SLOTS && ev->wlen >= 0; i++)
+            if(mallocWeights(
+                featureCount,
+                layerCount,
+                layerNodeCounts,
+                &ev->queue[i]
+            ) < 0)
+                ev->wlen = -1;
+        if(ev->wlen < 0) {
+            freeEvaluator();
+            return -1;
+        }
     }
 
-    return result;
+    pthread_mutex_init(&ev->lock, NULL);
+    pthread_cond_init(&ev->posted, NULL);
+    pthread_cond_init(&ev->freed, NULL);
+    if(pthread_create(&ev->thread, NULL, evaluate, ev) != 0) {
+        perror("error `startEvaluator`: creating thread");
+        pthread_mutex_destroy(&ev->lock);
+        pthread_cond_destroy(&ev->posted);
+        pthread_cond_destroy(&ev->freed);
+        freeEvaluator();
+        return -2;
+    }
+    return 0;
 }
 
 /**
- * getPrediction
+ * snapshotDue
+ *
+ * @returns
+ *   1 if the weights after `epoch` epochs are to be evaluated; otherwise, 0.
  */
-static double getPrediction(
+static int snapshotDue(const int epoch) {
+    return evalInterval > 0 && epoch % evalInterval == 0;
+}
+
+/**
+ * offerSnapshot
+ *   Queues a copy of the weights after `epoch` epochs for the evaluator,
+ *   first waiting for a free slot if the queue is full. Does nothing before
+ *   `startEvaluator`.
+ */
+static void offerSnapshot(const double * const w, const int epoch) {
+    evaluator * const ev = &evaluation;
+    int slot;
+    if(ev->wlen <= 0)
+        return;
+    pthread_mutex_lock(&ev->lock);
+    while(ev->queued == SNAPSHOT_SLOTS)
+        pthread_cond_wait(&ev->freed, &ev->lock);
+    slot = (ev->head + ev->queued) % SNAPSHOT_SLOTS;
+    memcpy(ev->queue[slot], w, ev->wlen * sizeof(double));
+    ev->epochs[slot] = epoch;
+    ev->queued++;
+    pthread_cond_signal(&ev->posted);
+    pthread_mutex_unlock(&ev->lock);
+}
+
+/**
+ * finishEvaluator
+ *   Waits for the evaluator to score the last snapshot and stop. The test set
+ *   is kept until `freeEvaluator`.
+ *
+ * @returns
+ *   The number of examples of the test set if successfully loaded;
+ *   otherwise, a negative number.
+ */
+static int finishEvaluator(void) {
+    evaluator * const ev = &evaluation;
+    int i;
+    pthread_mutex_lock(&ev->lock);
+    ev->done = 1;
+    pthread_cond_signal(&ev->posted);
+    pthread_mutex_unlock(&ev->lock);
+    pthread_join(ev->thread, NULL);
+    pthread_mutex_destroy(&ev->lock);
+    pthread_cond_destroy(&ev->posted);
+    pthread_cond_destroy(&ev->freed);
+    for(i = 0; i < SNAPSHOT_SLOTS; i++)
+        freeWeights(&ev->queue[i]);
+    freeWeights(&ev->current);
+    ev->wlen = 0;
+    return ev->count;
+}
+
+/**
+ * freeEvaluator
+ */
+static void freeEvaluator(void) {
+    evaluator * const ev = &evaluation;
+    int i;
+    free(ev->x);
+    free(ev->y);
+    ev->x = NULL;
+    ev->y = NULL;
+    for(i = 0; i < SNAPSHOT_SLOTS; i++)
+        freeWeights(&ev->queue[i]);
+    freeWeights(&ev->current);
+    ev->wlen = 0;
+}
+
+/**
+ * evaluate
+ *
+ * @summary
+ *   Body of the evaluator thread.
+ *
+ * @description
+ *   Loads the test set, then prints the accuracy and F1 of each snapshot,
+ *   which together make the learning curve. Training is told to stop once
+ *   `patience` snapshots in a row have not bettered the best F1 so far.
+ */
+static void *evaluate(void *arg) {
+    evaluator * const ev = (evaluator *)arg;
+    int epoch;
+    double *tmp, accuracy, f1;
+
+    /*** Preload the test set. ***/
+    ev->count = load(TEST_SET, ev->x, ev->y);
+    if(ev->count > 0)
+        project(ev->count, ev->x, ev->featureMap, ev->featureCount);
+
+    for(;;) {
+        /*** Wait for a snapshot, or the end of training. ***/
+        pthread_mutex_lock(&ev->lock);
+        while(ev->queued == 0 && !ev->done)
+            pthread_cond_wait(&ev->posted, &ev->lock);
+        if(ev->queued == 0) {
+            pthread_mutex_unlock(&ev->lock);
+            break;
+        }
+        tmp = ev->current;
+        ev->current = ev->queue[ev->head];
+        ev->queue[ev->head] = tmp;
+        epoch = ev->epochs[ev->head];
+        ev->head = (ev->head + 1) % SNAPSHOT_SLOTS;
+        ev->queued--;
+        pthread_cond_signal(&ev->freed);
+        pthread_mutex_unlock(&ev->lock);
+        if(ev->count < 1)
+            continue;
+
+        /*** Score the snapshot. ***/
+        score(
+            ev->x,
+            ev->y,
+            ev->count,
+            ev->featureCount,
+            ev->layerCount,
+            ev->layerNodeCounts,
+            ev->current,
+            &accuracy,
+            &f1
+        );
+        printf("epoch %d: accuracy: %f, f1: %f\n", epoch, accuracy, f1);
+
+        /*** Stop training if the F1 has not improved for a while. ***/
+        if(f1 > ev->bestF1) {
+            ev->bestF1 = f1;
+            ev->sinceBest = 0;
+        }
+        else if(patience > 0 && ++ev->sinceBest >= patience)
+            atomic_store(&ev->stop, 1);
+    }
+    return NULL;
+}
+
+/**
+ * trainExample
+ *
+ * @summary
+ *   Updates the weights of a network from one example.
+ *
+ * @description
+ *   Computes the hidden layer features into `z`, then back propagates the
+ *   derivitive of the square loss one layer at a time into `d`, the deltas of
+ *   the hidden nodes. The weights are only updated once every delta is known,
+ *   and those of the first layer only for the non-zero features. Without
+ *   hidden layers, the single output node is cheaper to update densely.
+ */
+static void trainExample(
     const double * const x_i,
+    const double y_i,
+    const int featureCount,
     const int layerCount,
-    const int layerNodeCount,
-    const double * const w
+    const int * const layerNodeCounts,
+    const double gamma0,
+    double * const w,
+    double * const z,
+    double * const d,
+    lazyDecay * const lazy
 ) {
-    int i, j, k;
-    const double *wptr = w;
-    double *zcur, *znxt = v, *ztmp, dot, result = 0;
-    if(layerCount > 0) {
-        /*** First layer. ***/
-        znxt[0] = 1;
-        for(i = 1; i < layerNodeCount + 1; i++) {
-            dot = 0;
-            for(j = 0; j < FEATURE_COUNT; j++)
-                dot += wptr[j] * x_i[j];
-            // znxt[i] = dot;
-            znxt[i] = 1.0 / (1.0 + exp(-dot));
-            wptr = (wptr + FEATURE_COUNT);
-        }
+    int l, inCount = featureCount, outCount, nzCount, nz[featureCount];
+    const double *zcur = x_i;
+    double *wptr = w, *znxt = z, *dcur = d, *dnxt, dLy;
+
+    /*** Perceptron. ***/
+    if(layerCount == 0) {
+        dLy = dot(w, x_i, featureCount) - y_i;
+        updateLayer(w, x_i, featureCount, 1, &dLy, gamma0, lazy->decay);
+        return;
+    }
+
+    /*** Bring the weights of the non-zero features up to date. ***/
+    nzCount = nonzeros(x_i, featureCount, nz);
+    catchUpColumns(
+        w, layerNodeCounts[0], layerNodeCounts[0],
+        nz, nzCount, lazy
+    );
+
+    /*** Compute yp and remember hidden layer features. ***/
+    for(l = 0; l < layerCount; l++) {
+        if(l == 0)
+            forwardInput(x_i, nz, nzCount, w, layerNodeCounts[0], znxt);
+        else
+            forwardLayer(zcur, inCount, wptr, layerNodeCounts[l], znxt);
+        wptr = (wptr + layerNodeCounts[l] * inCount);
+        dcur = (dcur + layerNodeCounts[l]);
+        inCount = layerNodeCounts[l] + 1;
         zcur = znxt;
-        znxt = u;
-        /*** Remaining layers. ***/
-        for(i = 1; i < layerCount; i++) {
-            znxt[0] = 1;
-            for(j = 0; j < layerNodeCount; j++) {
-                dot = 0;
-                for(k = 0; k < layerNodeCount + 1; k++)
-                    dot += wptr[k] * zcur[k];
-                // znxt[j + 1] = dot;
-                znxt[j + 1] = 1.0 / (1.0 + exp(-dot));
-                wptr = (wptr + layerNodeCount + 1);
-            }
-            ztmp = zcur;
+        znxt = (znxt + inCount);
+    }
+
+    /*** Save derivitive of square loss. ***/
+    dLy = dot(wptr, zcur, inCount) - y_i;
+
+    /*** Back propagate the deltas of the hidden layers. ***/
+    outCount = 1;
+    dnxt = &dLy;
+    for(l = layerCount - 1; l >= 0; l--) {
+        dcur = (dcur - layerNodeCounts[l]);
+        backLayer(wptr, inCount, outCount, dnxt, zcur, dcur);
+        dnxt = dcur;
+        outCount = layerNodeCounts[l];
+        inCount = (l > 0 ? layerNodeCounts[l - 1] + 1 : featureCount);
+        zcur = (l > 0 ? zcur - inCount : x_i);
+        wptr = (wptr - outCount * inCount);
+    }
+
+    /*** Update the first layer. ***/
+    updateColumns(
+        w, x_i, nz, nzCount, layerNodeCounts[0], layerNodeCounts[0],
+        d, gamma0, lazy->decay
+    );
+    advanceLazy(nz, nzCount, lazy);
+
+    /*** Update the remaining hidden layers and the output node. ***/
+    wptr = (w + layerNodeCounts[0] * featureCount);
+    zcur = z;
+    dcur = (d + layerNodeCounts[0]);
+    inCount = layerNodeCounts[0] + 1;
+    for(l = 1; l < layerCount; l++) {
+        updateLayer(
+            wptr, zcur, inCount, layerNodeCounts[l],
+            dcur, gamma0, lazy->decay
+        );
+        wptr = (wptr + layerNodeCounts[l] * inCount);
+        zcur = (zcur + inCount);
+        dcur = (dcur + layerNodeCounts[l]);
+        inCount = layerNodeCounts[l] + 1;
+    }
+    updateLayer(wptr, zcur, inCount, 1, &dLy, gamma0, lazy->decay);
+}
+
+/**
+ * trainRows
+ *
+ * @summary
+ *   Trains one epoch with the nodes of each layer split between the threads
+ *   of the pool.
+ *
+ * @description
+ *   Runs on every thread of the pool. Each thread computes the features,
+ *   deltas and weight updates of its own range of nodes in each layer, and
+ *   the threads meet at a barrier whenever the next step needs the whole
+ *   layer. Every thread computes the output node itself; thread 0 updates it
+ *   and the stamps of the input columns.
+ */
+static void trainRows(const int thread, const int threadCount, void *arg) {
+    trainArgs * const args = (trainArgs *)arg;
+    const int * const layerNodeCounts = args->layerNodeCounts;
+    const int featureCount = args->featureCount;
+    const double decay = args->lazy->decay;
+    int i, l, lo, hi, inCount, outCount, nzCount, nz[featureCount];
+    const double *x_i, *zcur;
+    double *wptr, *znxt, *dcur, *dnxt, dLy;
+
+    for(i = 0; i < args->count; i++) {
+        x_i = (args->x + i * featureCount);
+        wptr = args->w;
+        zcur = x_i;
+        znxt = args->z;
+        dcur = args->d;
+        inCount = featureCount;
+
+        /*** Bring this thread's weights of the non-zero features up to ***/
+        /*** date.                                                      ***/
+        nzCount = nonzeros(x_i, featureCount, nz);
+        poolRange(layerNodeCounts[0], thread, threadCount, &lo, &hi);
+        catchUpColumns(
+            args->w + lo, layerNodeCounts[0], hi - lo,
+            nz, nzCount, args->lazy
+        );
+
+        /*** Compute yp and remember hidden layer features. ***/
+        for(l = 0; l < args->layerCount; l++) {
+            poolRange(layerNodeCounts[l], thread, threadCount, &lo, &hi);
+            if(thread == 0)
+                znxt[0] = 1;
+            if(l == 0)
+                forwardSparse(
+                    x_i, nz, nzCount,
+                    wptr + lo, layerNodeCounts[0], hi - lo,
+                    znxt + 1 + lo
+                );
+            else
+                forwardRows(
+                    zcur, inCount,
+                    wptr + lo * inCount, hi - lo,
+                    znxt + 1 + lo
+                );
+            poolBarrier();
+            wptr = (wptr + layerNodeCounts[l] * inCount);
+            dcur = (dcur + layerNodeCounts[l]);
+            inCount = layerNodeCounts[l] + 1;
             zcur = znxt;
-            znxt = ztmp;
+            znxt = (znxt + inCount);
         }
-        for(i = 0; i < layerNodeCount + 1; i++)
-            result += wptr[i] * zcur[i];
-    }
-    else {
-        for(i = 0; i < FEATURE_COUNT; i++)
-            result += x_i[i] * w[i];
+
+        /*** Save derivitive of square loss. ***/
+        dLy = dot(wptr, zcur, inCount) - args->y[i];
+
+        /*** Back propagate the deltas of the hidden layers. ***/
+        outCount = 1;
+        dnxt = &dLy;
+        for(l = args->layerCount - 1; l >= 0; l--) {
+            poolRange(layerNodeCounts[l], thread, threadCount, &lo, &hi);
+            dcur = (dcur - layerNodeCounts[l]);
+            backNodes(wptr, inCount, outCount, dnxt, zcur, dcur, lo, hi);
+            dnxt = dcur;
+            outCount = layerNodeCounts[l];
+            inCount = (l > 0 ? layerNodeCounts[l - 1] + 1 : featureCount);
+            zcur = (l > 0 ? zcur - inCount : x_i);
+            wptr = (wptr - outCount * inCount);
+            /*** The next layer down needs all of these deltas, and no ***/
+            /*** weight may change until every delta is known.         ***/
+            poolBarrier();
+        }
+
+        /*** Update this thread's rows of every layer. ***/
+        for(l = 0; l < args->layerCount; l++) {
+            poolRange(layerNodeCounts[l], thread, threadCount, &lo, &hi);
+            if(l == 0)
+                updateColumns(
+                    wptr + lo, zcur, nz, nzCount,
+                    layerNodeCounts[0], hi - lo,
+                    dcur + lo, args->gamma0, decay
+                );
+            else
+                updateLayer(
+                    wptr + lo * inCount, zcur, inCount, hi - lo,
+                    dcur + lo, args->gamma0, decay
+                );
+            wptr = (wptr + layerNodeCounts[l] * inCount);
+            zcur = (l > 0 ? zcur + inCount : args->z);
+            dcur = (dcur + layerNodeCounts[l]);
+            inCount = layerNodeCounts[l] + 1;
+        }
+        if(thread == 0) {
+            updateLayer(wptr, zcur, inCount, 1, &dLy, args->gamma0, decay);
+            advanceLazy(nz, nzCount, args->lazy);
+        }
+
+        /*** The next example needs every update. ***/
+        poolBarrier();
     }
-    return result < 0 ? -1 : 1;
 }
 
 /**
- * parseArgs
+ * trainModels
+ *   Trains the models of an ensemble assigned to a thread of the pool.
+ */
+static void trainModels(const int thread, const int threadCount, void *arg) {
+    int m, ret;
+    ensembleArgs * const args = (ensembleArgs *)arg;
+    for(m = thread; m < modelCount; m += threadCount) {
+        ret = trainModel(args, m);
+        if(ret < 0)
+            args->ret = ret;
+    }
+}
+
+/**
+ * trainModel
+ *
+ * @summary
+ *   Trains model `m` of a bagged ensemble.
+ *
+ * @description
+ *   The model is trained on a bootstrap sample of the examples, which is a
+ *   list of indices into the shared `x` and `y`; it is reshuffled every epoch
+ *   instead of the examples. The trained weights are packed into `args->w` so
+ *   that the first layers of all models are interleaved by feature, the
+ *   weights of feature `k` of every model in a row of `modelCount` times the
+ *   first layer's width, followed by the remaining layers of each model in
+ *   turn.
+ */
+static int trainModel(void *arg, const int m) {
+    ensembleArgs * const args = (ensembleArgs *)arg;
+    const int featureCount = args->featureCount;
+    int e, i, k, wlen, nodeCount, firstLen, *index;
+    unsigned int seed = args->seed + m * 0x9e3779b9u;
+    double *w, *z, *d;
+    lazyDecay lazy;
+
+    /*** Allocate weights, z, the deltas, the stamps and the sample. ***/
+    wlen = mallocWeights(
+        featureCount,
+        args->layerCount,
+        args->layerNodeCounts,
+        &w
+    );
+    if(wlen < 0)
+        return wlen;
+    if(mallocz(args->layerCount, args->layerNodeCounts, &z) < 0) {
+        freeWeights(&w);
+        return -1;
+    }
+    if(mallocz(args->layerCount, args->layerNodeCounts, &d) < 0) {
+        freeWeights(&w);
+        freez(&z);
+        return -1;
+    }
+    if(mallocStamps(featureCount, &lazy.stamp) < 0) {
+        freeWeights(&w);
+        freez(&z);
+        freez(&d);
+        return -1;
+    }
+    index = (int *)malloc(args->count * sizeof(int));
+    if(index == NULL) {
+        perror("error `trainModel`: not enough memory");
+        freeWeights(&w);
+        freez(&z);
+        freez(&d);
+        freeStamps(&lazy.stamp);
+        return -1;
+    }
+    lazy.decay = args->decay;
+    lazy.step = 0;
+
+    /*** Initialize weights and draw the sample. ***/
+    seedWeights(wlen, w, &seed);
+    bootstrap(args->count, index, &seed);
+
+    /*** Train over epochs. ***/
+    for(e = 0; e < args->epochs; e++) {
+        shuffleIndex(args->count, index, &seed);
+        for(i = 0; i < args->count; i++) {
+            if(kern != NULL)
+                kern->train(
+                    featureCount, args->x + index[i] * featureCount,
+                    args->y[index[i]], args->gamma0, w, z, d, &lazy
+                );
+            else
+                trainExample(
+                    args->x + index[i] * featureCount, args->y[index[i]],
+                    featureCount, args->layerCount, args->layerNodeCounts,
+                    args->gamma0, w, z, d, &lazy
+                );
+        }
+    }
+
+    /*** Pack the model into the ensemble. ***/
+    nodeCount = (args->layerCount > 0 ? args->layerNodeCounts[0] : 1);
+    firstLen = nodeCount * featureCount;
+    flushLazy(w, featureCount, nodeCount, &lazy);
+    for(k = 0; k < featureCount; k++)
+        memcpy(
+            args->w + (k * modelCount + m) * nodeCount,
+            w + k * nodeCount,
+            nodeCount * sizeof(double)
+        );
+    memcpy(
+        args->w + modelCount * firstLen + m * (wlen - firstLen),
+        w + firstLen,
+        (wlen - firstLen) * sizeof(double)
+    );
+
+    /*** Cleanup memory. ***/
+    free(index);
+    freeWeights(&w);
+    freez(&z);
+    freez(&d);
+    freeStamps(&lazy.stamp);
+
+    return 0;
+}
+
+/**
+ * autotune
+ *
+ * @summary
+ *   Picks the fastest kernel and number of threads for the topology.
+ *
+ * @description
+ *   Times one epoch of `train` over the first TUNE_SAMPLE examples for each
+ *   candidate: the specialized kernel, if one was generated, on 1 thread, and
+ *   the generic kernels with 1, 2, 4, ... threads up to the number of online
+ *   processors. The threads of `trainRows` do not use the specialized kernel,
+ *   so it is only a candidate on 1 thread. Without hidden layers, more than 1
+ *   thread trains by parameter mixing, which gives a different model, so only
+ *   the kernel is tuned. Each candidate runs at least TUNE_RUNS times and
+ *   TUNE_SECONDS in total, and its fastest run counts. The winner is left in
+ *   `generic` and `threadCount`; the weights are trained again afterwards.
+ *   The runs shuffle a copy of the sample, and with `--seed` the generator is
+ *   seeded again afterwards, so tuning does not change the model.
+ *
+ * @returns
+ *   0 if successful; otherwise, a negative number.
+ */
+static int autotune(
+    const double * const x,
+    const double * const y,
+    const int count,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double gamma0,
+    const double lambda,
+    double * const w,
+    int * const generic
+) {
+    const kernel * const special = findKernel(
+        featureCount,
+        layerCount,
+        layerNodeCounts
+    );
+    const int sample = (count < TUNE_SAMPLE ? count : TUNE_SAMPLE);
+    const int every = evalInterval;
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int g, r, t, maxThreads, bestGeneric = 1, bestThreads = 1;
+    double seconds, total, fastest, best = -1;
+    double *xs, *ys;
+    struct timespec start, stop;
+
+    if(processors < 1)
+        processors = 1;
+
+    xs = (double *)malloc(sample * featureCount * sizeof(double));
+    ys = (double *)malloc(sample * sizeof(double));
+    if(xs == NULL || ys == NULL) {
+        perror("error `autotune`: not enough memory");
+        free(xs);
+        free(ys);
+        return -1;
+    }
+    memcpy(xs, x, sample * featureCount * sizeof(double));
+    memcpy(ys, y, sample * sizeof(double));
+
+    /*** The evaluator is not started yet; the timed runs take no ***/
+    /*** snapshots.                                               ***/
+    evalInterval = 0;
+    for(g = (special != NULL ? 0 : 1); g <= 1; g++) {
+        kern = (g ? NULL : special);
+        maxThreads = (g && layerCount > 0 ? (int)processors : 1);
+        for(t = 1; t <= maxThreads; t *= 2) {
+            threadCount = t;
+            if(poolInit(t) < 0) {
+                evalInterval = every;
+                free(xs);
+                free(ys);
+                return -1;
+            }
+            fastest = -1;
+            total = 0;
+            for(r = 0; r < TUNE_RUNS || total < TUNE_SECONDS; r++) {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                if(train(
+                    xs,
+                    ys,
+                    sample,
+                    featureCount,
+                    layerCount,
+                    layerNodeCounts,
+                    1,
+                    gamma0,
+                    lambda,
+                    w
+                ) < 0) {
+                    poolCleanup();
+                    evalInterval = every;
+                    free(xs);
+                    free(ys);
+                    return -1;
+                }
+                clock_gettime(CLOCK_MONOTONIC, &stop);
+                seconds = (stop.tv_sec - start.tv_sec)
+                    + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+                total += seconds;
+                if(fastest < 0 || seconds < fastest)
+                    fastest = seconds;
+            }
+            poolCleanup();
+            printf("tune: %s kernel, %d threads: %f s\n",
+                kern != NULL ? kern->name : "generic", t, fastest);
+            if(best < 0 || fastest < best) {
+                best = fastest;
+                bestGeneric = g;
+                bestThreads = t;
+            }
+        }
+    }
+
+    free(xs);
+    free(ys);
+    if(seed >= 0)
+        setSeed((unsigned int)seed);
+
+    kern = NULL;
+    (*generic) = bestGeneric;
+    threadCount = bestThreads;
+    evalInterval = every;
+    return 0;
+}
+
+/**
+ * trainShards
+ *
+ * @summary
+ *   Trains one epoch of the model without hidden layers by iterative
+ *   parameter mixing.
+ *
+ * @description
+ *   Runs on every thread of the pool. Each thread copies the weights `args->w`
+ *   and trains its copy on its own shard of the examples. Every `mixInterval`
+ *   examples, and at the end of the shard, the threads meet at a barrier and
+ *   average the copies back into `args->w`, each thread a range of the
+ *   features, and then start again from the average.
+ */
+static void trainShards(const int thread, const int threadCount, void *arg) {
+    mixArgs * const args = (mixArgs *)arg;
+    const int featureCount = args->featureCount;
+    const int shard = (args->count + threadCount - 1) / threadCount;
+    const int interval = (mixInterval > 0 ? mixInterval : shard);
+    double * const w = (args->local + thread * args->stride);
+    double * const sum = (
+        args->sum != NULL ? args->sum + thread * args->stride : NULL
+    );
+    int i, r, lo, hi, klo, khi, end;
+
+    poolRange(args->count, thread, threadCount, &lo, &hi);
+    poolRange(featureCount, thread, threadCount, &klo, &khi);
+    memcpy(w, args->w, featureCount * sizeof(double));
+
+    /*** Every thread takes part in each round, even once its shard is ***/
+    /*** done, since the shards differ by at most one example.         ***/
+    for(r = 0; r * interval < shard; r++) {
+        end = (hi - lo > (r + 1) * interval ? lo + (r + 1) * interval : hi);
+        for(i = lo + r * interval; i < end; i++)
+            stepLinear(
+                w, sum,
+                args->x + i * featureCount, featureCount, args->y[i],
+                args->gamma0, args->decay
+            );
+
+        /*** Average the copies of every thread. ***/
+        poolBarrier();
+        averageCopies(
+            args->local, args->stride, threadCount,
+            klo, khi, args->w
+        );
+        poolBarrier();
+        memcpy(w, args->w, featureCount * sizeof(double));
+    }
+}
+
+/**
+ * learnOnline
+ *
+ * @summary
+ *   Updates a saved model from examples read from stdin.
+ *
+ * @description
+ *   Each line of stdin is one example in the format read by `load`; it is
+ *   projected with the model's feature map and applied as one stochastic
+ *   gradient step. If `outPath` is given, the model is saved to it every
+ *   `interval` examples and once more at the end of input, each time after the
+ *   decay the first layer has missed is applied. With more than one thread,
+ *   each step splits the nodes of every hidden layer between them, as in
+ *   `trainRows`. The update latency and throughput are reported at the end.
+ */
+static int learnOnline(
+    const char * const inPath,
+    const char * const outPath,
+    const int interval,
+    const double gamma0,
+    const double lambda,
+    const int generic
+) {
+    int i, ret = 0, wlen, featureCount, featureMap[FEATURE_COUNT];
+    int layerCount, *layerNodeCounts;
+    long count = 0;
+    double *w, *z, *d, x_i[FEATURE_COUNT], y_i;
+    lazyDecay lazy;
+    trainArgs args;
+    double latency, latencySum = 0, latencyMax = 0, seconds;
+    char line[0x400];
+    struct timespec start, stop, t0, t1;
+
+    /*** Load the model. ***/
+    wlen = loadModel(
+        inPath,
+        &featureCount,
+        featureMap,
+        &layerCount,
+        &layerNodeCounts,
+        &w
+    );
+    if(wlen < 0)
+        return -3;
+    printf("model: %s\n", inPath);
+    printf("features: %d\n", featureCount);
+    printf("layers: %d\n", layerCount);
+    printf("layer nodes:");
+    for(i = 0; i < layerCount; i++)
+        printf("%s%d", i > 0 ? "," : " ", layerNodeCounts[i]);
+    printf("\n");
+    printf("gamma: %f\n", gamma0);
+    printf("lambda: %f\n", lambda);
+
+    /*** The threads split the nodes of each hidden layer. ***/
+    if(layerCount == 0 && threadCount > 1) {
+        fprintf(stderr, "error `learnOnline`: `-t` requires a model with"
+            " hidden layers\n");
+        free(layerNodeCounts);
+        freeWeights(&w);
+        return -1;
+    }
+
+    /*** Allocate z, the deltas of the hidden nodes and the stamps of ***/
+    /*** the input columns.                                           ***/
+    if(mallocz(layerCount, layerNodeCounts, &z) < 0) {
+        free(layerNodeCounts);
+        freeWeights(&w);
+        return -2;
+    }
+    if(mallocz(layerCount, layerNodeCounts, &d) < 0) {
+        free(layerNodeCounts);
+        freeWeights(&w);
+        freez(&z);
+        return -2;
+    }
+    if(mallocStamps(featureCount, &lazy.stamp) < 0) {
+        free(layerNodeCounts);
+        freeWeights(&w);
+        freez(&z);
+        freez(&d);
+        return -2;
+    }
+    lazy.decay = 1 - gamma0 * lambda;
+    lazy.step = 0;
+
+    if(!generic && threadCount == 1)
+        kern = findKernel(featureCount, layerCount, layerNodeCounts);
+    printf("kernel: %s\n", kern != NULL ? kern->name : "generic");
+    printf("threads: %d\n", threadCount);
+    fflush(stdout);
+
+    /*** Each example is one call of `trainRows` on the worker threads. ***/
+    if(poolInit(threadCount) < 0) {
+        free(layerNodeCounts);
+        freeWeights(&w);
+        freez(&z);
+        freez(&d);
+        freeStamps(&lazy.stamp);
+        return -2;
+    }
+    args.x = x_i;
+    args.y = &y_i;
+    args.count = 1;
+    args.featureCount = featureCount;
+    args.layerCount = layerCount;
+    args.layerNodeCounts = layerNodeCounts;
+    args.gamma0 = gamma0;
+    args.w = w;
+    args.z = z;
+    args.d = d;
+    args.lazy = &lazy;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while(fgets(line, 0x400, stdin) != NULL) {
+        if(line[0] == '\n' || line[0] == 0)
+            continue;
+        if(parseExample(line, x_i, &y_i) < 0)
+            continue;
+        project(1, x_i, featureMap, featureCount);
+
+        /*** Update weights from the example. ***/
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if(threadCount > 1)
+            poolRun(trainRows, &args);
+        else if(kern != NULL)
+            kern->train(featureCount, x_i, y_i, gamma0, w, z, d, &lazy);
+        else
+            trainExample(
+                x_i, y_i,
+                featureCount, layerCount, layerNodeCounts,
+                gamma0, w, z, d, &lazy
+            );
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        latency = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        latencySum += latency;
+        if(latency > latencyMax)
+            latencyMax = latency;
+
+        count++;
+
+        /*** Publish a snapshot of the model. ***/
+        if(outPath != NULL && count % interval == 0) {
+            flushLazy(
+                w,
+                featureCount,
+                layerCount > 0 ? layerNodeCounts[0] : 1,
+                &lazy
+            );
+            ret = saveModel(
+                outPath,
+                featureCount,
+                featureMap,
+                layerCount,
+                layerNodeCounts,
+                w
+            );
+            if(ret < 0)
+                break;
+            printf("snapshot: %ld\n", count);
+            fflush(stdout);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    poolCleanup();
+
+    /*** Publish the final model. ***/
+    if(ret == 0 && outPath != NULL && count % interval != 0) {
+        flushLazy(
+            w,
+            featureCount,
+            layerCount > 0 ? layerNodeCounts[0] : 1,
+            &lazy
+        );
+        ret = saveModel(
+            outPath,
+            featureCount,
+            featureMap,
+            layerCount,
+            layerNodeCounts,
+            w
+        );
+        if(ret == 0)
+            printf("snapshot: %ld\n", count);
+    }
+
+    seconds = (stop.tv_sec - start.tv_sec)
+        + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("examples: %ld\n", count);
+    printf(
+        "update latency: %f us mean, %f us max\n",
+        count > 0 ? latencySum / count * 1e6 : 0,
+        latencyMax * 1e6
+    );
+    printf("throughput: %f lines/s\n", seconds > 0 ? count / seconds : 0);
+
+    /*** Cleanup memory. ***/
+    free(layerNodeCounts);
+    freeWeights(&w);
+    freez(&z);
+    freez(&d);
+    freeStamps(&lazy.stamp);
+
+    return ret < 0 ? -5 : 0;
+}
+
+/**
+ * getPrediction
+ */
+static double getPrediction(
+    const double * const x_i,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w
+) {
+    int i, inCount = featureCount, nzCount, nz[featureCount];
+    const double *wptr = w, *zcur = x_i;
+    double *znxt = v, *ztmp = u, result;
+    if(modelCount > 1)
+        return getEnsemblePrediction(
+            x_i,
+            featureCount,
+            layerCount,
+            layerNodeCounts,
+            w
+        );
+    if(kern != NULL)
+        result = kern->predict(featureCount, x_i, w, v, u);
+    else {
+        /*** Hidden layers. ***/
+        nzCount = nonzeros(x_i, featureCount, nz);
+        for(i = 0; i < layerCount; i++) {
+            if(i == 0)
+                forwardInput(x_i, nz, nzCount, w, layerNodeCounts[0], znxt);
+            else
+                forwardLayer(zcur, inCount, wptr, layerNodeCounts[i], znxt);
+            wptr = (wptr + layerNodeCounts[i] * inCount);
+            inCount = layerNodeCounts[i] + 1;
+            zcur = znxt;
+            znxt = ztmp;
+            ztmp = (double *)zcur;
+        }
+        /*** Output node. ***/
+        result = dot(wptr, zcur, inCount);
+    }
+    return result < 0 ? -1 : 1;
+}
+
+/**
+ * getEnsemblePrediction
+ *
+ * @summary
+ *   Predicts the label of an example by majority vote of an ensemble.
+ *
+ * @description
+ *   `w` holds the models packed by `trainModel`. Their first layers are
+ *   interleaved by feature, so they are computed as one wide layer in a single
+ *   pass over the non-zero features, and then each model finishes its own
+ *   remaining layers.
+ */
+static double getEnsemblePrediction(
+    const double * const x_i,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const double * const w
+) {
+    int i, m, inCount, votes = 0, nzCount, nz[featureCount];
+    const int nodeCount = (layerCount > 0 ? layerNodeCounts[0] : 1);
+    const int firstLen = nodeCount * featureCount;
+    const int tailLen = (
+        weightsSize(featureCount, layerCount, layerNodeCounts) - firstLen
+    );
+    const double *wptr, *zcur;
+    double *znxt, *ztmp, result;
+
+    /*** First layers of every model. ***/
+    nzCount = nonzeros(x_i, featureCount, nz);
+    if(layerCount > 0)
+        forwardSparse(
+            x_i, nz, nzCount, w,
+            modelCount * nodeCount, modelCount * nodeCount,
+            ze
+        );
+    else
+        sumSparse(x_i, nz, nzCount, w, modelCount, modelCount, ze);
+
+    for(m = 0; m < modelCount; m++) {
+        if(layerCount > 0) {
+            wptr = (w + modelCount * firstLen + m * tailLen);
+
+            /*** Bias feature of the first hidden layer. ***/
+            v[0] = 1;
+            memcpy(v + 1, ze + m * nodeCount, nodeCount * sizeof(double));
+            zcur = v;
+            znxt = u;
+            ztmp = v;
+            inCount = nodeCount + 1;
+
+            /*** Remaining hidden layers. ***/
+            for(i = 1; i < layerCount; i++) {
+                forwardLayer(zcur, inCount, wptr, layerNodeCounts[i], znxt);
+                wptr = (wptr + layerNodeCounts[i] * inCount);
+                inCount = layerNodeCounts[i] + 1;
+                zcur = znxt;
+                znxt = ztmp;
+                ztmp = (double *)zcur;
+            }
+            /*** Output node. ***/
+            result = dot(wptr, zcur, inCount);
+        }
+        else
+            result = ze[m];
+        votes += (result < 0 ? -1 : 1);
+    }
+    return votes < 0 ? -1 : 1;
+}
+
+/**
+ * parseLayerNodeCounts
+ *   Parses a comma separated list of layer widths.
+ *
+ * @returns
+ *   The number of widths if successfully parsed; otherwise, -1.
+ */
+static int parseLayerNodeCounts(const char * const arg, int **layerNodeCounts) {
+    int count = 1;
+    const char *token = arg;
+    char *end;
+    for(token = arg; (*token) != 0; token++)
+        if((*token) == ',')
+            count++;
+    free((*layerNodeCounts));
+    (*layerNodeCounts) = (int *)malloc(count * sizeof(int));
+    if((*layerNodeCounts) == NULL) {
+        perror("error `parseLayerNodeCounts`: not enough memory");
+        return -1;
+    }
+    token = arg;
+    for(count = 0; ; count++) {
+        (*layerNodeCounts)[count] = (int)strtol(token, &end, 10);
+        if(end == token || (*layerNodeCounts)[count] < 1)
+            return -1;
+        if((*end) == 0)
+            return count + 1;
+        if((*end) != ',')
+            return -1;
+        token = end + 1;
+    }
+}
+
+/**
+ * parseArgs
+ *   Options kept in static data, such as `threadCount` and `seed`, are set
+ *   directly; the others are returned through the pointers.
  */
 static int parseArgs(
     const int argc,
     char **argv,
     int *layerCount,
-    int *layerNodeCount,
+    int **layerNodeCounts,
     int *epochs,
-    double *gamma0
+    double *gamma0,
+    int *generic,
+    char **modelPath,
+    char **onlinePath,
+    int *interval,
+    double *lambda,
+    int *scaling,
+    int *tune,
+    int *manual
 ) {
-    int i;
+    int i, nodeCount = FEATURE_COUNT / 2, widthCount = 0, layersGiven = 0;
+    int batchGiven = 0, snapshotsGiven = 0;
     for(i = 1; i < argc; i++) {
         /*** layerCount ***/
         if(strcmp(argv[i], "-l") == 0) {
+            batchGiven = 1;
             i++;
             if(i == argc) {
                 fprintf(stderr, "error: unexpected end of argument list\n");
@@ -515,25 +2121,29 @@ static int parseArgs(
                 printUsage(argv[0]);
                 return -2;
             }
+            layersGiven = 1;
         }
-        /*** layerNodeCount ***/
+        /*** layerNodeCounts ***/
         else if(strcmp(argv[i], "-n") == 0) {
+            batchGiven = 1;
             i++;
             if(i == argc) {
                 fprintf(stderr, "error: unexpected end of argument list\n");
                 printUsage(argv[0]);
                 return -3;
             }
-            (*layerNodeCount) = atoi(argv[i]);
-            if((*layerNodeCount) < 1) {
+            widthCount = parseLayerNodeCounts(argv[i], layerNodeCounts);
+            if(widthCount < 1) {
                 fprintf(stderr, "error: number of layer nodes must be greater"
                     " than 0\n");
                 printUsage(argv[0]);
                 return -4;
             }
+            nodeCount = (*layerNodeCounts)[0];
         }
         /*** epochs ***/
         else if(strcmp(argv[i], "-e") == 0) {
+            batchGiven = 1;
             i++;
             if(i == argc) {
                 fprintf(stderr, "error: unexpected end of argument list\n");
@@ -563,6 +2173,178 @@ static int parseArgs(
                 return -8;
             }
         }
+        /*** generic ***/
+        else if(strcmp(argv[i], "-k") == 0) {
+            (*generic) = 1;
+            (*manual) = 1;
+        }
+        /*** modelPath ***/
+        else if(strcmp(argv[i], "-o") == 0) {
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -12;
+            }
+            (*modelPath) = argv[i];
+        }
+        /*** threadCount ***/
+        else if(strcmp(argv[i], "-t") == 0) {
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -13;
+            }
+            threadCount = atoi(argv[i]);
+            if(threadCount < 1) {
+                fprintf(stderr, "error: number of threads must be greater"
+                    " than 0\n");
+                printUsage(argv[0]);
+                return -14;
+            }
+            (*manual) = 1;
+        }
+        /*** onlinePath ***/
+        else if(strcmp(argv[i], "-u") == 0) {
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -15;
+            }
+            (*onlinePath) = argv[i];
+        }
+        /*** interval ***/
+        else if(strcmp(argv[i], "-p") == 0) {
+            snapshotsGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -16;
+            }
+            (*interval) = atoi(argv[i]);
+            if((*interval) < 1) {
+                fprintf(stderr, "error: snapshot interval must be greater"
+                    " than 0\n");
+                printUsage(argv[0]);
+                return -17;
+            }
+        }
+        /*** modelCount ***/
+        else if(strcmp(argv[i], "-m") == 0) {
+            batchGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -18;
+            }
+            modelCount = atoi(argv[i]);
+            if(modelCount < 1) {
+                fprintf(stderr, "error: number of models must be greater"
+                    " than 0\n");
+                printUsage(argv[0]);
+                return -19;
+            }
+        }
+        /*** lambda ***/
+        else if(strcmp(argv[i], "-r") == 0) {
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -21;
+            }
+            (*lambda) = atof(argv[i]);
+            if((*lambda) < 0) {
+                fprintf(stderr, "error: lambda must be non-negative\n");
+                printUsage(argv[0]);
+                return -22;
+            }
+        }
+        /*** mixInterval ***/
+        else if(strcmp(argv[i], "-i") == 0) {
+            batchGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -24;
+            }
+            mixInterval = atoi(argv[i]);
+            if(mixInterval < 1) {
+                fprintf(stderr, "error: mix interval must be greater than"
+                    " 0\n");
+                printUsage(argv[0]);
+                return -25;
+            }
+        }
+        /*** averaged ***/
+        else if(strcmp(argv[i], "-v") == 0) {
+            batchGiven = 1;
+            averaged = 1;
+        }
+        /*** scaling ***/
+        else if(strcmp(argv[i], "-s") == 0) {
+            batchGiven = 1;
+            (*scaling) = 1;
+        }
+        /*** tune ***/
+        else if(strcmp(argv[i], "--tune") == 0) {
+            batchGiven = 1;
+            (*tune) = 1;
+        }
+        /*** seed ***/
+        else if(strcmp(argv[i], "--seed") == 0) {
+            batchGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -26;
+            }
+            seed = atol(argv[i]);
+            if(seed < 0) {
+                fprintf(stderr, "error: seed must be non-negative\n");
+                printUsage(argv[0]);
+                return -27;
+            }
+        }
+        /*** evalInterval ***/
+        else if(strcmp(argv[i], "-c") == 0) {
+            batchGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -28;
+            }
+            evalInterval = atoi(argv[i]);
+            if(evalInterval < 1) {
+                fprintf(stderr, "error: evaluation interval must be greater"
+                    " than 0\n");
+                printUsage(argv[0]);
+                return -29;
+            }
+        }
+        /*** patience ***/
+        else if(strcmp(argv[i], "-w") == 0) {
+            batchGiven = 1;
+            i++;
+            if(i == argc) {
+                fprintf(stderr, "error: unexpected end of argument list\n");
+                printUsage(argv[0]);
+                return -30;
+            }
+            patience = atoi(argv[i]);
+            if(patience < 1) {
+                fprintf(stderr, "error: patience must be greater than 0\n");
+                printUsage(argv[0]);
+                return -31;
+            }
+        }
         /*** unexpected argument ***/
         else {
             fprintf(stderr, "error: unexpected argument\n");
@@ -570,6 +2352,98 @@ static int parseArgs(
             return -9;
         }
     }
+
+    /*** Online learning takes the topology from the model and only ***/
+    /*** updates it from stdin.                                     ***/
+    if((*onlinePath) != NULL && batchGiven) {
+        fprintf(stderr, "error: `-u` cannot be combined with `-e`, `-l`,"
+            " `-n`, `-m`, `-c`, `-w`, `-s`, `-i`, `-v`, `--tune` or"
+            " `--seed`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -35;
+    }
+    if(snapshotsGiven && ((*onlinePath) == NULL || (*modelPath) == NULL)) {
+        fprintf(stderr, "error: `-p` requires `-u` and `-o`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -36;
+    }
+
+    /*** The weight decay of each step must keep the weights' sign. ***/
+    if((*gamma0) * (*lambda) >= 1) {
+        fprintf(stderr, "error: gamma0 * lambda must be less than 1\n");
+        printUsage(argv[0]);
+        return -23;
+    }
+
+    /*** Tuning chooses the kernel and threads itself. ***/
+    if((*tune) && (*manual)) {
+        fprintf(stderr, "error: `--tune` cannot be combined with `-k` or"
+            " `-t`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -33;
+    }
+
+    /*** Early stopping needs the snapshots to stop on. ***/
+    if(patience > 0 && evalInterval == 0) {
+        fprintf(stderr, "error: `-w` requires `-c`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -32;
+    }
+
+    /*** An ensemble trains one model per thread and is not saved. ***/
+    if(modelCount > 1 && (threadCount > 1 || (*modelPath) != NULL
+        || (*scaling) || (*tune) || evalInterval > 0 || mixInterval > 0
+        || averaged)) {
+        fprintf(stderr, "error: `-m` cannot be combined with `-t`, `-o`, `-s`,"
+            " `-c`, `-i`, `-v` or `--tune`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -20;
+    }
+
+    /*** A list of widths gives the number of hidden layers; a single ***/
+    /*** width is used for every hidden layer.                        ***/
+    if(widthCount > 1) {
+        if(layersGiven && (*layerCount) != widthCount) {
+            fprintf(stderr, "error: number of hidden layers does not match"
+                " the number of layer widths\n");
+            printUsage(argv[0]);
+            free((*layerNodeCounts));
+            (*layerNodeCounts) = NULL;
+            return -10;
+        }
+        (*layerCount) = widthCount;
+    }
+    else {
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = (int *)malloc(
+            ((*layerCount) > 0 ? (*layerCount) : 1) * sizeof(int)
+        );
+        if((*layerNodeCounts) == NULL) {
+            perror("error `parseArgs`: not enough memory");
+            return -11;
+        }
+        for(i = 0; i < (*layerCount); i++)
+            (*layerNodeCounts)[i] = nodeCount;
+    }
+
+    /*** Parameter mixing and averaging only train the linear model. ***/
+    if((*layerCount) > 0 && (mixInterval > 0 || averaged)) {
+        fprintf(stderr, "error: `-i` and `-v` require `-l 0`\n");
+        printUsage(argv[0]);
+        free((*layerNodeCounts));
+        (*layerNodeCounts) = NULL;
+        return -34;
+    }
     return 0;
 }
 
@@ -578,16 +2452,97 @@ static int parseArgs(
  */
 static void printUsage(const char *prgm) {
     printf("usage:\n");
-    printf("\t%s [-e <int>] [-l <int>] [-n <int>] [-g <double>]\n\n", prgm);
+    printf("\t%s [-e <int>] [-l <int>] [-n <int>[,<int>...]] [-g <double>]"
+        " [-r <double>]\n\t\t[-k] [-o <path>] [-t <int>] [-m <int>]"
+        " [-i <int>] [-v] [-s]\n\t\t[-c <int> [-w <int>]] [--tune]"
+        " [--seed <int>]\n", prgm);
+    printf("\t%s -u <path> [-g <double>] [-r <double>] [-k] [-t <int>]"
+        " [-o <path> [-p <int>]]\n\n", prgm);
     printf("Options:\n");
     printf("\t-e <int>       Specifies the number of epochs over which to"
         " train.\n");
     printf("\t               The default is 1.\n");
     printf("\t-l <int>       Specifies the number of hidden layers.\n");
     printf("\t               The default is 0.\n");
-    printf("\t-n <int>       Specifies the number of nodes per hidden"
+    printf("\t-n <int>[,<int>...]\n");
+    printf("\t               Specifies the number of nodes per hidden"
         " layer.\n");
+    printf("\t               A list gives the width of each hidden layer"
+        " and\n");
+    printf("\t               implies the number of hidden layers.\n");
     printf("\t               The default is 1.\n");
     printf("\t-g <double>    Specifies the gamma0 hyper parameter.\n");
-    printf("\t               The default is 0.01.\n\n");
-}
\ No newline at end of file
+    printf("\t               The default is 0.01.\n");
+    printf("\t-r <double>    Specifies the L2 regularization of the weights;"
+        " each\n");
+    printf("\t               step decays them by a factor of"
+        " 1 - gamma0 * lambda.\n");
+    printf("\t               The default is 0.\n");
+    printf("\t-k             Uses the generic kernels even if a specialized"
+        " kernel\n");
+    printf("\t               was generated for the topology.\n");
+    printf("\t-o <path>      Saves the trained model, including the map of"
+        " the\n");
+    printf("\t               feature columns it uses, to the given"
+        " file.\n");
+    printf("\t-t <int>       Specifies the number of threads that split the"
+        " nodes\n");
+    printf("\t               of each hidden layer while training, or the"
+        " examples\n");
+    printf("\t               if there are no hidden layers.\n");
+    printf("\t               The default is 1.\n");
+    printf("\t-i <int>       Without hidden layers, each thread trains its"
+        " own copy\n");
+    printf("\t               of the weights on a shard of the examples;"
+        " specifies\n");
+    printf("\t               the number of examples between averages of"
+        " the\n");
+    printf("\t               copies. The default is once per epoch.\n");
+    printf("\t-v             Without hidden layers, outputs the averaged"
+        " perceptron,\n");
+    printf("\t               the mean of the weights after every step.\n");
+    printf("\t-s             Also times a single-threaded run and reports"
+        " the\n");
+    printf("\t               speedup over it.\n");
+    printf("\t--tune         Benchmarks the kernels and thread counts for"
+        " the\n");
+    printf("\t               topology on a sample of the training set and"
+        " caches\n");
+    printf("\t               the fastest in `tune.<host>.cache`. Later runs"
+        " reuse\n");
+    printf("\t               it unless `-k` or `-t` is given. Without"
+        " hidden\n");
+    printf("\t               layers, only the kernel is tuned. Cannot be"
+        " combined\n");
+    printf("\t               with `-k` or `-t`.\n");
+    printf("\t-c <int>       Scores a snapshot of the weights on the test set"
+        " every\n");
+    printf("\t               given number of epochs, on a separate thread,"
+        " and\n");
+    printf("\t               prints the learning curve. Training only"
+        " waits if\n");
+    printf("\t               two snapshots are still queued for"
+        " scoring.\n");
+    printf("\t-w <int>       Stops training once the given number of"
+        " snapshots in a\n");
+    printf("\t               row have not improved the best F1.\n");
+    printf("\t--seed <int>   Seeds the random weights and shuffles so that"
+        " runs\n");
+    printf("\t               are repeatable. The default seeds with the"
+        " time.\n");
+    printf("\t-m <int>       Specifies the number of models of a bagged"
+        " ensemble,\n");
+    printf("\t               each trained on its own thread from a"
+        " bootstrap\n");
+    printf("\t               sample and tested by majority vote.\n");
+    printf("\t               The default is 1.\n");
+    printf("\t-u <path>      Loads the model at the given path and updates"
+        " it from\n");
+    printf("\t               the examples read from stdin, one per line.\n");
+    printf("\t               With `-o`, the model is saved atomically every"
+        " `-p`\n");
+    printf("\t               examples and at the end of input.\n");
+    printf("\t-p <int>       Specifies the number of examples between"
+        " snapshots.\n");
+    printf("\t               The default is 1000.\n\n");
+}
@@ -0,0 +1,229 @@
+/*******************************************************************************
+File: tune.c
+Created by: agent
+Date created: October 18, 2026
+
+Autotuning cache stuff.
+
+The configuration picked by `--tune` is cached as text, one line per topology:
+```
+<featureCount> <topology> <generic> <threadCount> <cpu model>
+```
+`topology` is the comma separated list of hidden layer widths, or `0` without
+hidden layers, and `cpu model` is the model name of `/proc/cpuinfo`. A line
+only applies if all three match. Each host has its own cache file,
+`tune.<hostname>.cache`, in the working directory.
+
+The cache is written to `<filePath>.tmp` and then renamed over `filePath`, so a
+reader never sees a partially written cache.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tune.h"
+
+#define LINE_LENGTH 0x400
+
+static void cpuModel(char * const);
+static void topologyKey(const int, const int * const, char * const);
+static int matchLine(
+    const char * const,
+    const int,
+    const char * const,
+    const char * const,
+    int * const,
+    int * const
+);
+
+/**
+ * tuneCachePath
+ *   `path` must have room for TUNE_PATH_LENGTH characters.
+ *
+ * @returns
+ *   0 if successful; otherwise, a negative number.
+ */
+int tuneCachePath(char * const path) {
+    char host[0x40];
+    if(gethostname(host, sizeof(host)) != 0) {
+        perror("error `tuneCachePath`: getting host name");
+        return -1;
+    }
+    host[sizeof(host) - 1] = 0;
+    snprintf(path, TUNE_PATH_LENGTH, "tune.%s.cache", host);
+    return 0;
+}
+
+/**
+ * loadTuning
+ *   A missing cache file is the same as a cache without a matching line.
+ *
+ * @returns
+ *   1 if a matching configuration was loaded into `generic` and
+ *   `threadCount`; 0 if there is none; otherwise, a negative number.
+ */
+int loadTuning(
+    const char * const filePath,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    int * const generic,
+    int * const threadCount
+) {
+    int found = 0;
+    char line[LINE_LENGTH], topology[LINE_LENGTH], cpu[LINE_LENGTH];
+    FILE *file;
+
+    file = fopen(filePath, "r");
+    if(file == NULL)
+        return 0;
+    cpuModel(cpu);
+    topologyKey(layerCount, layerNodeCounts, topology);
+    while(!found && fgets(line, LINE_LENGTH, file) != NULL)
+        found = matchLine(
+            line,
+            featureCount,
+            topology,
+            cpu,
+            generic,
+            threadCount
+        );
+    if(ferror(file)) {
+        perror("error `loadTuning`: reading file");
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return found;
+}
+
+/**
+ * saveTuning
+ *   Replaces the matching line of the cache, if any, and keeps the others.
+ *
+ * @returns
+ *   0 if successfully saved; otherwise, a negative number.
+ */
+int saveTuning(
+    const char * const filePath,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const int generic,
+    const int threadCount
+) {
+    int g, t;
+    char line[LINE_LENGTH], topology[LINE_LENGTH], cpu[LINE_LENGTH];
+    char tmpPath[TUNE_PATH_LENGTH + sizeof(".tmp")];
+    FILE *in, *out;
+
+    cpuModel(cpu);
+    topologyKey(layerCount, layerNodeCounts, topology);
+    sprintf(tmpPath, "%s.tmp", filePath);
+
+    out = fopen(tmpPath, "w");
+    if(out == NULL) {
+        perror("error `saveTuning`: opening file");
+        return -1;
+    }
+
+    /*** Keep the configurations of other topologies and CPUs. ***/
+    in = fopen(filePath, "r");
+    if(in != NULL) {
+        while(fgets(line, LINE_LENGTH, in) != NULL)
+            if(!matchLine(line, featureCount, topology, cpu, &g, &t))
+                fputs(line, out);
+        fclose(in);
+    }
+    fprintf(out, "%d %s %d %d %s\n", featureCount, topology, generic,
+        threadCount, cpu);
+
+    if(fclose(out) != 0) {
+        perror("error `saveTuning`: writing file");
+        return -2;
+    }
+
+    /*** Publish the cache. ***/
+    if(rename(tmpPath, filePath) != 0) {
+        perror("error `saveTuning`: renaming file");
+        return -3;
+    }
+    return 0;
+}
+
+/** Static functions **********************************************************/
+
+/**
+ * cpuModel
+ *   `model` must have room for LINE_LENGTH characters.
+ */
+static void cpuModel(char * const model) {
+    char line[LINE_LENGTH], *value;
+    FILE *file;
+
+    strcpy(model, "unknown");
+    file = fopen("/proc/cpuinfo", "r");
+    if(file == NULL)
+        return;
+    while(fgets(line, LINE_LENGTH, file) != NULL) {
+        if(strncmp(line, "model name", 10) != 0)
+            continue;
+        value = strchr(line, ':');
+        if(value == NULL)
+            continue;
+        value += strspn(value, ": \t");
+        value[strcspn(value, "\n")] = 0;
+        if((*value) != 0)
+            strcpy(model, value);
+        break;
+    }
+    fclose(file);
+}
+
+/**
+ * topologyKey
+ *   `key` must have room for LINE_LENGTH characters.
+ */
+static void topologyKey(
+    const int layerCount,
+    const int * const layerNodeCounts,
+    char * const key
+) {
+    int l;
+    strcpy(key, "0");
+    for(l = 0; l < layerCount && strlen(key) < LINE_LENGTH - 0x10; l++)
+        sprintf(key + (l > 0 ? strlen(key) : 0), "%s%d", l > 0 ? "," : "",
+            layerNodeCounts[l]);
+}
+
+/**
+ * matchLine
+ *
+ * @returns
+ *   1 if the line of the cache matches, with its configuration in `generic`
+ *   and `threadCount`; otherwise, 0.
+ */
+static int matchLine(
+    const char * const line,
+    const int featureCount,
+    const char * const topology,
+    const char * const cpu,
+    int * const generic,
+    int * const threadCount
+) {
+    int f, g, t, n = 0;
+    char key[LINE_LENGTH];
+    if(sscanf(line, "%d %1023s %d %d %n", &f, key, &g, &t, &n) < 4 || n == 0)
+        return 0;
+    if(f != featureCount || strcmp(key, topology) != 0 || t < 1)
+        return 0;
+    if(strncmp(line + n, cpu, strlen(cpu)) != 0
+        || (line[n + strlen(cpu)] != '\n' && line[n + strlen(cpu)] != 0))
+        return 0;
+    (*generic) = (g != 0);
+    (*threadCount) = t;
+    return 1;
+}
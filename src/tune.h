@@ -0,0 +1,28 @@
+/*******************************************************************************
+File: tune.h
+Created by: agent
+Date created: October 18, 2026
+
+Autotuning cache stuff.
+
+*******************************************************************************/
+
+#define TUNE_PATH_LENGTH 0x100
+
+int tuneCachePath(char * const path);
+int loadTuning(
+    const char * const filePath,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    int * const generic,
+    int * const threadCount
+);
+int saveTuning(
+    const char * const filePath,
+    const int featureCount,
+    const int layerCount,
+    const int * const layerNodeCounts,
+    const int generic,
+    const int threadCount
+);